@@ -1,5 +1,11 @@
 // internal
 #include "ai_system.hpp"
+#include "console.hpp"
+#include "world_system.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
 
 /* FLOOR-BOUND ENEMY PHYSICS CONFIGURATION */
 INTERNAL float enemyGravity = 250.f;
@@ -13,39 +19,86 @@ INTERNAL float enemyAirDeceleration = 500.f;
 // LADDER
 INTERNAL float ladderClimbSpeed = 64.f;
 
-float elapsedAICycleTime = 0.0f;
+// The stage's tiles, shared with the level module, handed over by Init for every stage
+INTERNAL std::shared_ptr<const TileGrid> levelGrid = std::make_shared<TileGrid>();
+
+// The level tiles as the path searches see them, rebuilt by Init for every stage
+INTERNAL std::shared_ptr<const NavGrid> navGrid;
+
+// A* searches of walking enemies in PathBehavior, solved on the job system and applied once they are done
+INTERNAL PathRequestQueue pathRequests;
+
+// Every flying enemy heads for the player's tile, so they all share one flow field toward it
+INTERNAL FlowField playerFlowField;
+INTERNAL u32 flowFieldRebuilds = 0;
+
+/* AI SCHEDULER CONFIGURATION */
+// Enemies this close to the player think every tick, whatever it costs
+INTERNAL float alwaysThinkDistance = 256.f;
+// What the rest may spend per tick, in microseconds
+INTERNAL float thinkBudgetUs = 500.f;
+// Lockstep mode ("ai_lockstep <n>", 0 = off): exactly n of the rest think per tick instead of the time budget, and
+// path results are waited for on the tick after they are requested, so the clock decides nothing. Costs frame time.
+INTERNAL u32 lockstepThinksPerTick = 0;
+
+using AIClock = std::chrono::high_resolution_clock;
+
+struct ThinkCandidate
+{
+	float urgency;
+	Entity entity;
+	bool operator<(const ThinkCandidate& other) const { return urgency < other.urgency; }
+};
+
+struct ThinkingEnemy
+{
+	Entity entity;
+	float elapsedTime; // ms since it last thought
+};
+
+// Picked by ScheduleThinking in Step, pathed by PathingStep in the same frame
+INTERNAL std::vector<ThinkingEnemy> thinkingEnemies;
+// Moving average of what PathingStep spends per enemy, charged to the budget when the enemy is picked
+INTERNAL float averagePathingUs = 0.f;
 
-// a representation of pathable tiles
-std::vector<std::vector<int>> levelTiles;
+struct AIScheduleStats
+{
+	u32 frames = 0;
+	u64 thinks = 0;
+	u64 deferred = 0;
+	u32 lastThinks = 0;
+	u32 lastDeferred = 0;
+	u32 mostDeferred = 0;
+	float lastUs = 0.f;
+};
+INTERNAL AIScheduleStats scheduleStats;
+
+INTERNAL float MicrosecondsSince(AIClock::time_point start)
+{
+	return (float)std::chrono::duration_cast<std::chrono::nanoseconds>(AIClock::now() - start).count() / 1000.f;
+}
 
 
 void AISystem::Step(float deltaTime)
 {
 	float elapsedTime = deltaTime * 1000.0f;
 	HandleSpriteSheetFrame(deltaTime);
-	elapsedAICycleTime += elapsedTime;
-	Entity playerEntity = registry.players.entities[0];
-	TransformComponent& playerTransform = registry.transforms.get(playerEntity);
 
 	for (int i = 0; i < registry.enemy.size(); ++i)
 	{
 		Entity enemyEntity = registry.enemy.entities[i];
 		Enemy& enemyComponent = registry.enemy.components[i];
 
-		if (registry.rangedBehaviors.has(enemyEntity) || registry.meleeBehaviors.has(enemyEntity)) {
-			if (!registry.deathTimers.has(enemyEntity)) {
-				EnemyAttack(enemyEntity, elapsedTime);
-			}
-		}
+		DeathTimer* deathTimer = registry.deathTimers.find(enemyEntity);
 
 		// Dying / colliding with player
-		if (registry.deathTimers.has(enemyEntity)) {
-			DeathTimer& time = registry.deathTimers.get(enemyEntity);
+		if (deathTimer) {
+			DeathTimer& time = *deathTimer;
 			time.elapsed_ms -= deltaTime * 1000.f;
 			enemyComponent.playerHurtCooldown = time.elapsed_ms;
 
 			if (time.elapsed_ms <= 0.f) {
-				registry.remove_all_components_of(enemyEntity);
+				registry.destroy_deferred(enemyEntity);
 			}
 
 		}
@@ -54,42 +107,21 @@ void AISystem::Step(float deltaTime)
 			{
 				enemyComponent.playerHurtCooldown -= deltaTime;
 			}
-			if (registry.walkingBehaviors.has(enemyEntity)) {
-				EnemyJumping(enemyEntity, deltaTime);
-			}
-		}
-		std::vector<Entity> toDeleteList;
-		for (int i = 0; i < registry.enemyMeleeAttacks.size(); i++) {
-			if (registry.enemyMeleeAttacks.components[i].elapsedTime > registry.enemyMeleeAttacks.components[i].existenceTime) {
-				toDeleteList.push_back(registry.enemyMeleeAttacks.entities[i]);
-			}
-			else {
-				registry.enemyMeleeAttacks.components[i].elapsedTime += elapsedTime;
-			}
-		}
-		for (int i = 0; i < toDeleteList.size(); i++) {
-			registry.remove_all_components_of(toDeleteList[i]);
+			enemyComponent.thinkIdleMs += elapsedTime;
 		}
 	}
 
-	// Pathing
-	if (elapsedAICycleTime >= 20.f) {
-		for (int i = 0; i < registry.enemy.size(); ++i)
-		{
-			Enemy& enemyComponent = registry.enemy.components[i];
-			const Entity& enemy = registry.enemy.entities[i];
-			// if entity in range of some amount of player (to reduce issues w/ run time) 
-
-			if (!registry.deathTimers.has(enemy) && registry.pathingBehaviors.has(enemy)) {
-				TransformComponent& enemyTransform = registry.transforms.get(enemy);
-				if (abs(playerTransform.position.x - enemyTransform.position.x) < 500 && abs(playerTransform.position.y - enemyTransform.position.y) < 500) {
-					Pathfind(enemy, elapsedTime);
-					MotionComponent& enemyMotionComponent = registry.motions.get(enemy);
-				}
-				elapsedAICycleTime = 0.f;
-			}
+	ScheduleThinking(elapsedTime);
+
+	for (int i = 0; i < registry.enemyMeleeAttacks.size(); i++) {
+		if (registry.enemyMeleeAttacks.components[i].elapsedTime > registry.enemyMeleeAttacks.components[i].existenceTime) {
+			registry.destroy_deferred(registry.enemyMeleeAttacks.entities[i]);
+		}
+		else {
+			registry.enemyMeleeAttacks.components[i].elapsedTime += elapsedTime;
 		}
 	}
+
 	bool bossLevel = true;
 	if (bossLevel) {
 		BossStep(elapsedTime);
@@ -97,105 +129,224 @@ void AISystem::Step(float deltaTime)
 
 }
 
-void AISystem::HandleSpriteSheetFrame(float deltaTime)
+// Picks the enemies that think this tick and runs their attacks and jumps, PathingStep paths the same ones.
+// Those close to the player always think. The rest go by urgency, the time since they last thought over their
+// distance to the player, until the tick's budget (or the lockstep count) is spent; what is left waits and only gets more urgent.
+void AISystem::ScheduleThinking(float elapsedTime)
 {
-	for (int i = 0; i < registry.sprites.size(); i++) {
-		SpriteComponent& sprite = registry.sprites.components[i];
-		Entity& entity = registry.sprites.entities[i];
-		if (registry.boss.has(entity) && sprite.sprite_sheet) {
-			MotionComponent& motion = registry.motions.get(entity);
-			Boss& boss = registry.boss.get(entity);
-
-			float x_velocity = motion.velocity.x;
-			bool faceRight = motion.facingRight;
-			bool reversed = sprite.reverse;
-			int prev_state = sprite.selected_animation;
-
-			if (faceRight != boss.facingRight) {
-				boss.facingRight = faceRight;
-				TransformComponent& transform = registry.transforms.get(entity);
-				if (boss.meleeState) {
-					transform.center.x = 108 - transform.center.x;
-				}
-				else if (boss.rangedState) {
-					transform.center.x = 45 - transform.center.x;
-				}
-				else if (boss.rageState) {
-					// TODO this, naively the same as ranged state
-				}
-			}
+	AIClock::time_point scheduleStart = AIClock::now();
+	vec2 playerPosition = registry.transforms.get(registry.players.entities[0]).position;
 
-			if (registry.deathTimers.has(entity)) {
-				// death
-				sprite.selected_animation = 2;
-			}
-			else if (boss.isBuffering) {
-				// attack!
-				sprite.selected_animation = 3;
-			}
-			else if (x_velocity != 0.f) {
-				// run
-				sprite.selected_animation = 1;
-			}
-			else {
-				// idle
-				sprite.selected_animation = 0;
+	LOCAL_PERSIST std::vector<ThinkCandidate> candidates;
+	candidates.clear();
+	thinkingEnemies.clear();
+	for (int i = 0; i < registry.enemy.size(); ++i)
+	{
+		Entity enemyEntity = registry.enemy.entities[i];
+		if (registry.deathTimers.has(enemyEntity)) {
+			continue;
+		}
+		float distance = length(registry.transforms.get(enemyEntity).position - playerPosition);
+		float idleMs = registry.enemy.components[i].thinkIdleMs;
+		float urgency = distance < alwaysThinkDistance ? INFINITY : idleMs / distance;
+		candidates.push_back({ urgency, enemyEntity });
+	}
+	std::make_heap(candidates.begin(), candidates.end());
+
+	float spentUs = 0.f;
+	u32 thinks = 0;
+	u32 budgetedThinks = 0;
+	while (!candidates.empty())
+	{
+		const ThinkCandidate next = candidates.front();
+		if (next.urgency != INFINITY) {
+			bool spent = lockstepThinksPerTick ? budgetedThinks >= lockstepThinksPerTick : spentUs >= thinkBudgetUs;
+			if (spent) {
+				break;
 			}
+		}
+		std::pop_heap(candidates.begin(), candidates.end());
+		candidates.pop_back();
+
+		AIClock::time_point thinkStart = AIClock::now();
+		Enemy& enemyComponent = registry.enemy.get(next.entity);
+		float idleMs = enemyComponent.thinkIdleMs;
+		enemyComponent.thinkIdleMs = 0.f;
+		Think(next.entity, idleMs);
+		thinkingEnemies.push_back({ next.entity, idleMs });
+		spentUs += MicrosecondsSince(thinkStart) + averagePathingUs;
+		if (next.urgency != INFINITY) {
+			++budgetedThinks;
+		}
+		++thinks;
+	}
+
+	u32 deferred = (u32)candidates.size();
+	++scheduleStats.frames;
+	scheduleStats.thinks += thinks;
+	scheduleStats.deferred += deferred;
+	scheduleStats.lastThinks = thinks;
+	scheduleStats.lastDeferred = deferred;
+	scheduleStats.mostDeferred = std::max(scheduleStats.mostDeferred, deferred);
+	scheduleStats.lastUs = MicrosecondsSince(scheduleStart);
+}
 
-			bool aligned = sprite.faceRight ? (faceRight != reversed) : (faceRight == reversed);
-			sprite.current_frame = (aligned && prev_state == sprite.selected_animation)
-				? sprite.current_frame : 0;
+// The part of an enemy's turn that can create entities, the rest is in Pathfind
+void AISystem::Think(Entity enemy_entity, float elapsedTime) {
+	if (registry.rangedBehaviors.has(enemy_entity) || registry.meleeBehaviors.has(enemy_entity)) {
+		EnemyAttack(enemy_entity, elapsedTime);
+	}
+	if (registry.walkingBehaviors.has(enemy_entity)) {
+		EnemyJumping(enemy_entity, elapsedTime / 1000.f);
+	}
+}
 
-			sprite.reverse = sprite.faceRight ? !faceRight : faceRight;
+// Only changes the motions and behaviors of pathing enemies, no entities come or go,
+// so the frame's task graph can run it next to SpriteSystem::Step
+void AISystem::PathingStep(float deltaTime)
+{
+	Entity playerEntity = registry.players.entities[0];
+	auto& playerTransform = registry.transforms.get(playerEntity);
+
+	// Paths requested on an earlier tick, if the workers are done with them (in lockstep mode, waited for).
+	// Entities that died or changed stage since are skipped by ApplyPathResult.
+	LOCAL_PERSIST std::vector<PathResult> finishedPaths;
+	if (pathRequests.Collect(finishedPaths, lockstepThinksPerTick != 0)) {
+		for (const PathResult& result : finishedPaths) {
+			ApplyPathResult(result);
+		}
+	}
+
+	// Only when the player moved to another tile (or the stage changed)
+	int playerTileX = (int)((playerTransform.position.x + 1) / 16);
+	int playerTileY = (int)((playerTransform.position.y + 1) / 16);
+	if (navGrid && !playerFlowField.IsBuiltFor(navGrid.get(), playerTileX, playerTileY)) {
+		playerFlowField.Build(*navGrid, playerTileX, playerTileY);
+		++flowFieldRebuilds;
+	}
+
+	// The enemies ScheduleThinking picked this frame
+	AIClock::time_point pathingStart = AIClock::now();
+	for (const ThinkingEnemy& thinking : thinkingEnemies) {
+		Entity enemy = thinking.entity;
+		if (!enemy.IsAlive() || !registry.pathingBehaviors.has(enemy) || registry.deathTimers.has(enemy)) {
 			continue;
 		}
-		if (registry.enemy.has(entity) && sprite.sprite_sheet) {
-			MotionComponent& motion = registry.motions.get(entity);
+		// if entity in range of some amount of player (to reduce issues w/ run time) 
+		auto& enemyTransform = registry.transforms.get(enemy);
+		if (abs(playerTransform.position.x - enemyTransform.position.x) < 500 && abs(playerTransform.position.y - enemyTransform.position.y) < 500) {
+			Pathfind(enemy, thinking.elapsedTime);
+		}
+	}
+	if (!thinkingEnemies.empty()) {
+		float perEnemyUs = MicrosecondsSince(pathingStart) / (float)thinkingEnemies.size();
+		averagePathingUs += (perEnemyUs - averagePathingUs) * 0.1f;
+	}
+	pathRequests.Dispatch();
+}
 
-			float x_velocity = motion.velocity.x;
-			bool faceRight = motion.facingRight;
-			bool reversed = sprite.reverse;
-			int prev_state = sprite.selected_animation;
+void AISystem::HandleSpriteSheetFrame(float deltaTime)
+{
+	registry.view<Boss, SpriteComponent, MotionComponent>().each([](Entity entity, Boss& boss, SpriteComponent& sprite, MotionComponent::Ref& motion) {
+		if (!sprite.sprite_sheet) {
+			return;
+		}
+
+		float x_velocity = motion.velocity.x;
+		bool faceRight = motion.facingRight;
+		bool reversed = sprite.reverse;
+		int prev_state = sprite.selected_animation;
 
-			if (registry.deathTimers.has(entity)) {
-				// death
-				sprite.selected_animation = 2;
+		if (faceRight != boss.facingRight) {
+			boss.facingRight = faceRight;
+			auto& transform = registry.transforms.get(entity);
+			if (boss.meleeState) {
+				transform.center.x = 108 - transform.center.x;
 			}
-			else if (x_velocity != 0.f) {
-				// run
-				sprite.selected_animation = 1;
+			else if (boss.rangedState) {
+				transform.center.x = 45 - transform.center.x;
 			}
-			else {
-				// idle
-				sprite.selected_animation = 0;
+			else if (boss.rageState) {
+				// TODO this, naively the same as ranged state
 			}
+		}
 
-			bool aligned = sprite.faceRight ? (faceRight != reversed) : (faceRight == reversed);
-			sprite.current_frame = (aligned && prev_state == sprite.selected_animation)
-				? sprite.current_frame : 0;
+		if (registry.deathTimers.has(entity)) {
+			// death
+			sprite.selected_animation = 2;
+		}
+		else if (boss.isBuffering) {
+			// attack!
+			sprite.selected_animation = 3;
+		}
+		else if (x_velocity != 0.f) {
+			// run
+			sprite.selected_animation = 1;
+		}
+		else {
+			// idle
+			sprite.selected_animation = 0;
+		}
 
-			sprite.reverse = sprite.faceRight ? !faceRight : faceRight;
+		bool aligned = sprite.faceRight ? (faceRight != reversed) : (faceRight == reversed);
+		sprite.current_frame = (aligned && prev_state == sprite.selected_animation)
+			? sprite.current_frame : 0;
+
+		sprite.reverse = sprite.faceRight ? !faceRight : faceRight;
+	});
+
+	registry.view<Enemy, SpriteComponent, MotionComponent>().each([](Entity entity, Enemy& enemy, SpriteComponent& sprite, MotionComponent::Ref& motion) {
+		// the boss is an enemy too but has its own animations above
+		if (!sprite.sprite_sheet || registry.boss.has(entity)) {
+			return;
 		}
-	}
+
+		float x_velocity = motion.velocity.x;
+		bool faceRight = motion.facingRight;
+		bool reversed = sprite.reverse;
+		int prev_state = sprite.selected_animation;
+
+		if (registry.deathTimers.has(entity)) {
+			// death
+			sprite.selected_animation = 2;
+		}
+		else if (x_velocity != 0.f) {
+			// run
+			sprite.selected_animation = 1;
+		}
+		else {
+			// idle
+			sprite.selected_animation = 0;
+		}
+
+		bool aligned = sprite.faceRight ? (faceRight != reversed) : (faceRight == reversed);
+		sprite.current_frame = (aligned && prev_state == sprite.selected_animation)
+			? sprite.current_frame : 0;
+
+		sprite.reverse = sprite.faceRight ? !faceRight : faceRight;
+	});
 }
 
 void AISystem::EnemyAttack(Entity enemy_entity, float elapsedTime) {
-	TransformComponent& enemyTransformComponent = registry.transforms.get(enemy_entity);
+	auto& enemyTransformComponent = registry.transforms.get(enemy_entity);
 	Entity playerEntity = registry.players.entities[0];
-	TransformComponent& playerTransform = registry.transforms.get(playerEntity);
-	vec2 pos = { (int)((enemyTransformComponent.position.x + 1) / 16), (int)((enemyTransformComponent.position.y + 1) / 16) };
-	if (pos[0] < levelTiles.size() && pos[1] < levelTiles[0].size() && pos[0] >= 0 && pos[1] >= 0) {
-		if (registry.rangedBehaviors.has(enemy_entity) && levelTiles[(int)pos[0]][(int)pos[1]] == 0)
+	auto& playerTransform = registry.transforms.get(playerEntity);
+	int tileX = (int)((enemyTransformComponent.position.x + 1) / 16);
+	int tileY = (int)((enemyTransformComponent.position.y + 1) / 16);
+	if (levelGrid->InBounds(tileX, tileY)) {
+		if (registry.rangedBehaviors.has(enemy_entity) && levelGrid->IsFree(tileX, tileY))
 		{
 			Enemy& enemy = registry.enemy.get(enemy_entity);
 			RangedBehavior& enemyRangedBehavior = registry.rangedBehaviors.get(enemy_entity);
-			MotionComponent& enemyMotion = registry.motions.get(enemy_entity);
+			auto& enemyMotion = registry.motions.get(enemy_entity);
 			Entity playerEntity = registry.players.entities.front();
-			MotionComponent& playerMotion = registry.motions.get(playerEntity);
-			TransformComponent& player_transform = registry.transforms.get(playerEntity);
+			auto& playerMotion = registry.motions.get(playerEntity);
+			auto& player_transform = registry.transforms.get(playerEntity);
 			vec2 diff_distance = player_transform.position - enemyTransformComponent.position;
 			if (diff_distance.x < 100 && diff_distance.x > -100 && diff_distance.y > -50 && diff_distance.y < 50) {
-				if (enemyRangedBehavior.elapsedTime > enemyRangedBehavior.attackCooldown) {
+				// lobbed shots arc over cover, straight ones hold fire (with the cooldown ready) until the player is in sight
+				bool clearShot = enemyRangedBehavior.lobbing || HasLineOfSight(*levelGrid, enemyTransformComponent.position, player_transform.position);
+				if (clearShot && enemyRangedBehavior.elapsedTime > enemyRangedBehavior.attackCooldown) {
 					enemyRangedBehavior.elapsedTime = 0;
 					if (enemyRangedBehavior.lobbing) {
 
@@ -222,7 +373,7 @@ void AISystem::EnemyAttack(Entity enemy_entity, float elapsedTime) {
 					}
 				}
 				else {
-					TransformComponent& enemyTransform = registry.transforms.get(enemy_entity);
+					auto& enemyTransform = registry.transforms.get(enemy_entity);
 					if (abs(playerTransform.position.x - enemyTransform.position.x) < 600 && abs(playerTransform.position.y - enemyTransform.position.y) < 600) {
 						enemyRangedBehavior.elapsedTime += elapsedTime;
 					}
@@ -234,10 +385,10 @@ void AISystem::EnemyAttack(Entity enemy_entity, float elapsedTime) {
 			MeleeBehavior& enemyMeleeBehavior = registry.meleeBehaviors.get(enemy_entity);
 			if (enemyMeleeBehavior.elapsedTime > 0) { //enemyMeleeBehavior.attackCooldown) {
 				enemyMeleeBehavior.elapsedTime = 0;
-				MotionComponent& enemyMotion = registry.motions.get(enemy_entity);
+				auto& enemyMotion = registry.motions.get(enemy_entity);
 				Entity playerEntity = registry.players.entities.front();
-				MotionComponent& playerMotion = registry.motions.get(playerEntity);
-				TransformComponent& player_transform = registry.transforms.get(playerEntity);
+				auto& playerMotion = registry.motions.get(playerEntity);
+				auto& player_transform = registry.transforms.get(playerEntity);
 				float diff_distance = player_transform.position.x - enemyTransformComponent.position.x;
 				if (enemyMeleeBehavior.requestingAttack) {
 					if (diff_distance > 0) {
@@ -349,7 +500,7 @@ void AISystem::Pathfind(Entity enemy_entity, float elapsedTime) {
 void AISystem::PatrolBehavior(Entity enemy_entity, float elapsedTime) {
 	if (registry.patrollingBehaviors.has(enemy_entity)) {
 		PatrollingBehavior& patrollingBehavior = registry.patrollingBehaviors.get(enemy_entity);
-		MotionComponent& motionComponent = registry.motions.get(enemy_entity);
+		auto& motionComponent = registry.motions.get(enemy_entity);
 
 		motionComponent.terminalVelocity.x = patrollingBehavior.patrolSpeed;
 		motionComponent.terminalVelocity.y = enemyMaxFallSpeed;
@@ -371,7 +522,7 @@ void AISystem::PatrolBehavior(Entity enemy_entity, float elapsedTime) {
 		// check if tile DL, DR is 0
 		// if DL is zero and going left, switch directions, except in case DR is zero, then set standstill = true
 		// vice versa for DR
-		TransformComponent& enemyTransformComponent = registry.transforms.get(enemy_entity);
+		auto& enemyTransformComponent = registry.transforms.get(enemy_entity);
 		vec2 enemyPos = { (int)((enemyTransformComponent.position.x + 1) / 16), (int)((enemyTransformComponent.position.y + 1) / 16) };
 		vec2 dlTile = enemyPos;
 		dlTile.x -= 1;
@@ -379,24 +530,9 @@ void AISystem::PatrolBehavior(Entity enemy_entity, float elapsedTime) {
 		vec2 drTile = enemyPos;
 		drTile.x += 1;
 		drTile.y += 1;
-		bool dlTileEmpty = false;
-		bool drTileEmpty = false;
-		if (dlTile.x < 0 || dlTile.x > levelTiles.size()) {
-			dlTileEmpty = true;
-		}
-		if (drTile.x < 0 || dlTile.x > levelTiles.size()) {
-			drTileEmpty = true;
-		}
-		if (!(dlTile.x < 0 || dlTile.x >= levelTiles.size() || dlTile.y < 0 || dlTile.y >= levelTiles[0].size())) {
-			if (levelTiles[dlTile.x][dlTile.y] == 0) {
-				dlTileEmpty = true;
-			}
-		}
-		if (!(drTile.x < 0 || drTile.x >= levelTiles.size() || drTile.y < 0 || drTile.y >= levelTiles[0].size())) {
-			if (levelTiles[drTile.x][drTile.y] == 0) {
-				drTileEmpty = true;
-			}
-		}
+		// off the sides of the level counts as empty, off the top or bottom doesn't
+		bool dlTileEmpty = dlTile.x < 0 || dlTile.x >= levelGrid->width || levelGrid->IsFree((int)dlTile.x, (int)dlTile.y);
+		bool drTileEmpty = drTile.x < 0 || drTile.x >= levelGrid->width || levelGrid->IsFree((int)drTile.x, (int)drTile.y);
 		if (drTileEmpty == true && dlTileEmpty == true) {
 			patrollingBehavior.standStill = true;
 			return;
@@ -427,168 +563,26 @@ void AISystem::PathBehavior(Entity enemy_entity) {
 	if (registry.pathingBehaviors.has(enemy_entity)) {
 		PathingBehavior& enemyPathingBehavior = registry.pathingBehaviors.get(enemy_entity);
 		Entity player_entity = registry.players.entities.front();
-		TransformComponent& playerTransformComponent = registry.transforms.get(player_entity);
-		TransformComponent& enemyTransformComponent = registry.transforms.get(enemy_entity);
-		MotionComponent& enemyMotionComponent = registry.motions.get(enemy_entity);
+		auto& playerTransformComponent = registry.transforms.get(player_entity);
+		auto& enemyTransformComponent = registry.transforms.get(enemy_entity);
+		auto& enemyMotionComponent = registry.motions.get(enemy_entity);
 
 		enemyMotionComponent.terminalVelocity.x = enemyPathingBehavior.pathSpeed;
 		enemyMotionComponent.terminalVelocity.y = enemyMaxFallSpeed;
 
-		if (registry.flyingBehaviors.has(enemy_entity)) {
-			struct ListEntry {
-				vec2 position;
-				int parent;
-				int cost;
-			};
-
-			// GOAL POS IS NOT CORRECTLY CONSIDERED HERE! be aware.
-			vec2 goalPos = { (int)((playerTransformComponent.position.x + 1) / 16), (int)((playerTransformComponent.position.y + 1) / 16) };
-			vec2 enemyPos = { (int)((enemyTransformComponent.position.x + 1) / 16), (int)((enemyTransformComponent.position.y + 1) / 16) };
-
-			if (goalPos[0] == enemyPos[0] && goalPos[1] == enemyPos[1]) {
-				return;
-			}
-
-			std::vector<ListEntry> openList;
-			std::vector<ListEntry> closedList;
-			ListEntry startPos = { enemyPos, NULL, 0 };
-			openList.push_back(startPos);
-
-			uint8 maxIter = 50;
-			uint8 currIter = 0;
-			std::vector<ListEntry> entriesSoFar;
-			while (!openList.empty())
-			{
-				if (maxIter < currIter) {
-					return;
-				}
-				int lowestIndexSoFar = 0;
-				ListEntry currentPos = { enemyPos, NULL, 999 };
-				for (int k = 0; k < openList.size(); k++) {
-					if (openList[k].cost + Heuristic(openList[k].position, goalPos) < currentPos.cost + Heuristic(currentPos.position, goalPos)) {
-						currentPos = openList[k];
-						lowestIndexSoFar = k;
-					}
-				}
-				entriesSoFar.push_back(currentPos);
-				openList.erase(openList.begin() + lowestIndexSoFar);
-				closedList.push_back(currentPos);
-				if (currentPos.position == goalPos) {
-					// goal found
-					// go to the start of the path, and set direction as next step to take
-					ListEntry currentEntry = currentPos;
-					vec2 prevPos = currentEntry.position;
-					currentEntry.parent = currentPos.parent;
-					while (currentEntry.position != entriesSoFar[currentEntry.parent].position) {
-						prevPos = currentEntry.position;
-						currentEntry = entriesSoFar[currentEntry.parent];
-					}
-					/* TODO make the open air A* feel better
-					desire for A* :
-						if we want to go from Y to A and Z is on the path, and if the tiles to the right and below
-						Y are open, go diagonal. still need to check for clipping. this should go after setting default direction, for elegance sake
-						XXXXX
-						XYXXX
-						XXZXA
-						XXXXX
-					possible solution: draw a line from Y to A, if its not obstructed then perform the optimal.
-					alternate solution: use acceleration. I forsee this breaking tight searching
-					if (currIter >= 2) {
-						vec2 secondLastEntryPosition = entriesSoFar[currIter - 1].position;
-						vec2 thirdLastEntryPosition  = entriesSoFar[currIter - 2].position;
-						// NW on path
-						// SW on path
-						// SE on path
-						// NE on path
-					}
-					*/
-
-					vec2 direction = prevPos - enemyPos;
-
-					// Clipping (being unable to path properly because of tile hitting non center of enemy) resolving section
-					enemyMotionComponent.velocity = direction * 25.f;
-					auto& enemyCollider = registry.colliders.get(enemy_entity);
-					float spriteWidth = enemyCollider.collision_pos.x;
-					float spriteHeight = enemyCollider.collision_pos.y;
-					vec2 enemyPosR = { ((int)((enemyTransformComponent.position.x + spriteWidth) / 16)),  ((int)(enemyTransformComponent.position.y / 16)) };
-					vec2 enemyPosL = { ((int)((enemyTransformComponent.position.x - spriteWidth) / 16)),  ((int)(enemyTransformComponent.position.y / 16)) };
-					vec2 enemyPosB = { ((int)(enemyTransformComponent.position.x / 16)),  ((int)((enemyTransformComponent.position.y + spriteHeight) / 16)) };
-					vec2 enemyPosA = { ((int)(enemyTransformComponent.position.x / 16)),  ((int)((enemyTransformComponent.position.y - spriteHeight) / 16)) };
-					bool isClippingTLL = direction.x < 0 && enemyPosA != enemyPos && levelTiles[(size_t)enemyPos.x - 1][(size_t)enemyPos.y - 1] != 0;
-					bool isClippingTLU = direction.y < 0 && enemyPosL != enemyPos && levelTiles[(size_t)enemyPos.x - 1][(size_t)enemyPos.y - 1] != 0;
-					bool isClippingTRR = direction.x > 0 && enemyPosA != enemyPos && levelTiles[(size_t)enemyPos.x + 1][(size_t)enemyPos.y - 1] != 0;
-					bool isClippingTRU = direction.y < 0 && enemyPosR != enemyPos && levelTiles[(size_t)enemyPos.x + 1][(size_t)enemyPos.y - 1] != 0;
-					bool isClippingBLL = direction.x < 0 && enemyPosB != enemyPos && levelTiles[(size_t)enemyPos.x - 1][(size_t)enemyPos.y + 1] != 0;
-					bool isClippingBLD = direction.y > 0 && enemyPosL != enemyPos && levelTiles[(size_t)enemyPos.x - 1][(size_t)enemyPos.y + 1] != 0;
-					bool isClippingBRR = direction.x > 0 && enemyPosB != enemyPos && levelTiles[(size_t)enemyPos.x + 1][(size_t)enemyPos.y + 1] != 0;
-					bool isClippingBRD = direction.y > 0 && enemyPosR != enemyPos && levelTiles[(size_t)enemyPos.x + 1][(size_t)enemyPos.y + 1] != 0;
-					float clipVelocity = 15.f;
-					if (isClippingBRD || isClippingTRU) {
-						enemyMotionComponent.velocity.x = -clipVelocity;
-					}
-					else if (isClippingBLD || isClippingTLU) {
-						enemyMotionComponent.velocity.x = clipVelocity;
-					}
-					else if (isClippingBRR || isClippingBLL) {
-						enemyMotionComponent.velocity.y = -clipVelocity;
-					}
-					else if (isClippingTRR || isClippingTLL) {
-						enemyMotionComponent.velocity.y = clipVelocity;
-					}
-					enemyMotionComponent.acceleration.x = 0;
-					enemyMotionComponent.acceleration.y = 0;
-					return;
-				}
+		// GOAL POS IS NOT CORRECTLY CONSIDERED HERE! be aware.
+		vec2 goalPos = { (int)((playerTransformComponent.position.x + 1) / 16), (int)((playerTransformComponent.position.y + 1) / 16) };
+		vec2 enemyPos = { (int)((enemyTransformComponent.position.x + 1) / 16), (int)((enemyTransformComponent.position.y + 1) / 16) };
 
-				std::vector<vec2> adjacentSquares;
-				vec2 above = { currentPos.position[0],     currentPos.position[1] - 1 };
-				vec2 right = { currentPos.position[0] + 1, currentPos.position[1] };
-				vec2 below = { currentPos.position[0],     currentPos.position[1] + 1 };
-				vec2 left = { currentPos.position[0] - 1, currentPos.position[1] };
-
-				adjacentSquares.push_back(above);
-				adjacentSquares.push_back(right);
-				adjacentSquares.push_back(below);
-				adjacentSquares.push_back(left);
-
-				for (vec2 adjacentSquare : adjacentSquares) {
-					if (adjacentSquare[0] >= 0 && adjacentSquare[1] >= 0 && adjacentSquare[0] < levelTiles.size() && adjacentSquare[1] < levelTiles[0].size()) {
-						// if its a free tile
-						if (levelTiles[(size_t)adjacentSquare[0]][(size_t)adjacentSquare[1]] == 0) {
-							bool inClosedList = false;
-							for (const ListEntry& closedEntry : closedList) {
-								vec2 position = closedEntry.position;
-								if (position[0] == adjacentSquare[0] && position[1] == adjacentSquare[1]) {
-									inClosedList = true;
-									break;
-								}
-							}
-							if (inClosedList) {
-								continue;
-							}
-							bool inOpenList = false;
-							ListEntry* openListVersion;
-							for (ListEntry listEntry : openList) {
-								if (listEntry.position[0] == adjacentSquare[0] && listEntry.position[1] == adjacentSquare[1]) {
-									inClosedList = true;
-									openListVersion = &listEntry;
-									break;
-								}
-							}
-							if (inOpenList) {
-								if (currentPos.cost + 1 < openListVersion->cost) {
-									openListVersion->parent = currIter;
-								}
-							}
-							else {
-								ListEntry addEntry = { adjacentSquare, currIter, currentPos.cost + 1 };
-								openList.push_back(addEntry);
-							}
-						}
-					}
-				}
-				currIter++;
-			}
+		if (registry.flyingBehaviors.has(enemy_entity)) {
+			// the flow field toward the player's tile already knows the next step
+			PathResult result;
+			result.entity = enemy_entity;
+			result.agent = PATH_AGENT_FLYING;
+			result.start = enemyPos;
+			result.found = playerFlowField.IsBuiltFor(navGrid.get(), (int)goalPos.x, (int)goalPos.y)
+				&& playerFlowField.NextStep((int)enemyPos.x, (int)enemyPos.y, result.direction);
+			ApplyPathResult(result);
 		}
 		else if (registry.walkingBehaviors.has(enemy_entity)) {
 			// if dumb, else
@@ -615,166 +609,151 @@ void AISystem::PathBehavior(Entity enemy_entity) {
 			}
 			else {
 				enemyMotionComponent.acceleration.y = enemyGravity;
-				// smart walker
-				struct ListEntry {
-					vec2 position;
-					int parent;
-					int cost;
-				};
-
-				vec2 goalPos = { (int)((playerTransformComponent.position.x + 1) / 16), (int)((playerTransformComponent.position.y + 1) / 16) };
-				vec2 enemyPos = { (int)((enemyTransformComponent.position.x + 1) / 16), (int)((enemyTransformComponent.position.y + 1) / 16) };
-
-				if (goalPos[0] == enemyPos[0] && goalPos[1] == enemyPos[1]) {
-					return;
-				}
-
-				std::vector<ListEntry> openList;
-				std::vector<ListEntry> closedList;
-				ListEntry startPos = { enemyPos, NULL, 0 };
-				openList.push_back(startPos);
-
-				uint8 maxIter = 25;
-				uint8 currIter = 0;
-				std::vector<ListEntry> entriesSoFar;
-				while (!openList.empty())
-				{
-					if (maxIter < currIter) {
-						return;
-					}
-					int lowestIndexSoFar = 0;
-					ListEntry currentPos = { enemyPos, NULL, 999 };
-					for (int k = 0; k < openList.size(); k++) {
-						if (openList[k].cost + Heuristic(openList[k].position, goalPos) < currentPos.cost + Heuristic(currentPos.position, goalPos)) {
-							currentPos = openList[k];
-							lowestIndexSoFar = k;
-						}
-					}
-					entriesSoFar.push_back(currentPos);
-					openList.erase(openList.begin() + lowestIndexSoFar);
-					closedList.push_back(currentPos);
-					if (currentPos.position == goalPos) {
-						// goal found
-						// go to the start of the path, and set direction as next step to take
-						ListEntry currentEntry = currentPos;
-						vec2 prevPos = currentEntry.position;
-						currentEntry.parent = currentPos.parent;
-						while (currentEntry.position != entriesSoFar[currentEntry.parent].position) {
-							prevPos = currentEntry.position;
-							currentEntry = entriesSoFar[currentEntry.parent];
-						}
-
-						vec2 direction = prevPos - enemyPos;
-						// decelerate faster than accelerate, use the global level var?
-						walkingBehavior.jumpRequest = false;
-						if (direction.x != 0) {
-							enemyMotionComponent.acceleration.x = direction.x * enemyPathingBehavior.pathSpeed;
-							if (direction.x > 0 && enemyMotionComponent.velocity.x < 0 || direction.x < 0 && enemyMotionComponent.velocity.x > 0) {
-								enemyMotionComponent.acceleration.x *= 1.75;
-							}
-						}
-						else {
-							if (direction.y < 0) {
-								walkingBehavior.jumpRequest = true;
-							}
-						}
-						return;
-					}
+				// smart walker, solved on the workers, see ApplyPathResult
+				pathRequests.Submit({ enemy_entity, PATH_AGENT_WALKING, enemyPos, goalPos });
+			}
+		}
+		else {
+			// you can't do any sort of movement but you want to path - you're not set properly.
+		}
+	}
+}
 
-					std::vector<vec2> adjacentSquares;
-					vec2 above = { currentPos.position[0],     currentPos.position[1] - 1 };
-					vec2 right = { currentPos.position[0] + 1, currentPos.position[1] };
-					vec2 below = { currentPos.position[0],     currentPos.position[1] + 1 };
-					vec2 left = { currentPos.position[0] - 1, currentPos.position[1] };
-					if (below.x >= 0 && below.y >= 0 && below.x < levelTiles.size() && below.y < levelTiles[0].size()) {
-						if (levelTiles[(int)below.x][(int)below.y] == 0) { // if current tile has no floor
-							adjacentSquares.push_back(below);
-						}
-						else { // current tile has a floor (PROBABLY DOESNT WORK WITH LADDERS HERE..)
-							adjacentSquares.push_back(above);        // if current has floor
-						}
-					}
-					adjacentSquares.push_back(right);
-					adjacentSquares.push_back(left);
-
-					for (vec2 adjacentSquare : adjacentSquares) {
-						if (adjacentSquare[0] >= 0 && adjacentSquare[1] >= 0 && adjacentSquare[0] < levelTiles.size() && adjacentSquare[1] < levelTiles[0].size()) {
-							// if its a free tile
-							if (levelTiles[(size_t)adjacentSquare[0]][(size_t)adjacentSquare[1]] == 0) {
-								bool inClosedList = false;
-								for (const ListEntry& closedEntry : closedList) {
-									vec2 position = closedEntry.position;
-									if (position[0] == adjacentSquare[0] && position[1] == adjacentSquare[1]) {
-										inClosedList = true;
-										break;
-									}
-								}
-								if (inClosedList) {
-									continue;
-								}
-								bool inOpenList = false;
-								ListEntry* openListVersion;
-								for (ListEntry listEntry : openList) {
-									if (listEntry.position[0] == adjacentSquare[0] && listEntry.position[1] == adjacentSquare[1]) {
-										inClosedList = true;
-										openListVersion = &listEntry;
-										break;
-									}
-								}
-								if (inOpenList) {
-									if (currentPos.cost + 1 < openListVersion->cost) {
-										openListVersion->parent = currIter;
-									}
-								}
-								else {
-									ListEntry addEntry = { adjacentSquare, currIter, currentPos.cost + 1 };
-									openList.push_back(addEntry);
-								}
-							}
-						}
-					}
-					currIter++;
-				}
+// Steers the enemy along the first step of a path that was requested last cycle
+void AISystem::ApplyPathResult(const PathResult& result) {
+	Entity enemy_entity = result.entity;
+	if (!result.found || !enemy_entity.IsAlive() || !registry.pathingBehaviors.has(enemy_entity)) {
+		return;
+	}
+	PathingBehavior& enemyPathingBehavior = registry.pathingBehaviors.get(enemy_entity);
+	auto& enemyTransformComponent = registry.transforms.get(enemy_entity);
+	auto& enemyMotionComponent = registry.motions.get(enemy_entity);
+	const vec2 enemyPos = result.start;
+	const vec2 direction = result.direction;
+
+	if (result.agent == PATH_AGENT_FLYING && registry.flyingBehaviors.has(enemy_entity)) {
+		/* TODO make the open air A* feel better
+		desire for A* :
+			if we want to go from Y to A and Z is on the path, and if the tiles to the right and below
+			Y are open, go diagonal. still need to check for clipping. this should go after setting default direction, for elegance sake
+			XXXXX
+			XYXXX
+			XXZXA
+			XXXXX
+		possible solution: draw a line from Y to A, if its not obstructed then perform the optimal.
+		alternate solution: use acceleration. I forsee this breaking tight searching
+		*/
 
+		// Clipping (being unable to path properly because of tile hitting non center of enemy) resolving section
+		enemyMotionComponent.velocity = direction * 25.f;
+		auto& enemyCollider = registry.colliders.get(enemy_entity);
+		float spriteWidth = enemyCollider.collision_pos.x;
+		float spriteHeight = enemyCollider.collision_pos.y;
+		vec2 enemyPosR = { ((int)((enemyTransformComponent.position.x + spriteWidth) / 16)),  ((int)(enemyTransformComponent.position.y / 16)) };
+		vec2 enemyPosL = { ((int)((enemyTransformComponent.position.x - spriteWidth) / 16)),  ((int)(enemyTransformComponent.position.y / 16)) };
+		vec2 enemyPosB = { ((int)(enemyTransformComponent.position.x / 16)),  ((int)((enemyTransformComponent.position.y + spriteHeight) / 16)) };
+		vec2 enemyPosA = { ((int)(enemyTransformComponent.position.x / 16)),  ((int)((enemyTransformComponent.position.y - spriteHeight) / 16)) };
+		bool isClippingTLL = direction.x < 0 && enemyPosA != enemyPos && levelGrid->IsSolid((int)enemyPos.x - 1, (int)enemyPos.y - 1);
+		bool isClippingTLU = direction.y < 0 && enemyPosL != enemyPos && levelGrid->IsSolid((int)enemyPos.x - 1, (int)enemyPos.y - 1);
+		bool isClippingTRR = direction.x > 0 && enemyPosA != enemyPos && levelGrid->IsSolid((int)enemyPos.x + 1, (int)enemyPos.y - 1);
+		bool isClippingTRU = direction.y < 0 && enemyPosR != enemyPos && levelGrid->IsSolid((int)enemyPos.x + 1, (int)enemyPos.y - 1);
+		bool isClippingBLL = direction.x < 0 && enemyPosB != enemyPos && levelGrid->IsSolid((int)enemyPos.x - 1, (int)enemyPos.y + 1);
+		bool isClippingBLD = direction.y > 0 && enemyPosL != enemyPos && levelGrid->IsSolid((int)enemyPos.x - 1, (int)enemyPos.y + 1);
+		bool isClippingBRR = direction.x > 0 && enemyPosB != enemyPos && levelGrid->IsSolid((int)enemyPos.x + 1, (int)enemyPos.y + 1);
+		bool isClippingBRD = direction.y > 0 && enemyPosR != enemyPos && levelGrid->IsSolid((int)enemyPos.x + 1, (int)enemyPos.y + 1);
+		float clipVelocity = 15.f;
+		if (isClippingBRD || isClippingTRU) {
+			enemyMotionComponent.velocity.x = -clipVelocity;
+		}
+		else if (isClippingBLD || isClippingTLU) {
+			enemyMotionComponent.velocity.x = clipVelocity;
+		}
+		else if (isClippingBRR || isClippingBLL) {
+			enemyMotionComponent.velocity.y = -clipVelocity;
+		}
+		else if (isClippingTRR || isClippingTLL) {
+			enemyMotionComponent.velocity.y = clipVelocity;
+		}
+		enemyMotionComponent.acceleration.x = 0;
+		enemyMotionComponent.acceleration.y = 0;
+	}
+	else if (result.agent == PATH_AGENT_WALKING && registry.walkingBehaviors.has(enemy_entity)) {
+		auto& walkingBehavior = registry.walkingBehaviors.get(enemy_entity);
+		// decelerate faster than accelerate, use the global level var?
+		walkingBehavior.jumpRequest = result.jump;
+		if (direction.x != 0) {
+			enemyMotionComponent.acceleration.x = direction.x * enemyPathingBehavior.pathSpeed;
+			if (direction.x > 0 && enemyMotionComponent.velocity.x < 0 || direction.x < 0 && enemyMotionComponent.velocity.x > 0) {
+				enemyMotionComponent.acceleration.x *= 1.75;
 			}
 		}
 		else {
-			// you can't do any sort of movement but you want to path - you're not set properly.
+			if (direction.y < 0) {
+				walkingBehavior.jumpRequest = true;
+			}
 		}
 	}
 }
 
+void AISystem::SetLockstep(u32 thinksPerTick) {
+	lockstepThinksPerTick = thinksPerTick;
+}
+
+void AISystem::PrintStats() {
+	float frames = (float)std::max(scheduleStats.frames, 1u);
+	console_printf("think schedule: %.1f enemies thought and %.1f were deferred per frame on average, last frame %u and %u (most deferred %u)\n",
+		(float)scheduleStats.thinks / frames, (float)scheduleStats.deferred / frames, scheduleStats.lastThinks, scheduleStats.lastDeferred, scheduleStats.mostDeferred);
+	if (lockstepThinksPerTick) {
+		console_printf("think schedule: last tick took %.1f us, lockstep with %u thinks beyond the close ones, pathing %.2f us per enemy\n", scheduleStats.lastUs, lockstepThinksPerTick, averagePathingUs);
+	} else {
+		console_printf("think schedule: last tick took %.1f us of a %.0f us budget, pathing %.2f us per enemy\n", scheduleStats.lastUs, thinkBudgetUs, averagePathingUs);
+	}
+	console_printf("flow field toward the player rebuilt %u times\n", flowFieldRebuilds);
+	console_printf("walker path requests: %u solved, %u replaced by a newer one while waiting for a batch\n", pathRequests.requestsSolved, pathRequests.requestsReplaced);
+	if (navGrid) {
+		console_printf("walker platform graph: %u spans, %u links for %u tiles\n", (u32)navGrid->platforms.spans.size(), (u32)navGrid->platforms.links.size(), navGrid->width * navGrid->height);
+	}
+}
+
 bool AISystem::PlayerInAwarenessBubble(Entity enemy_entity) {
 	Entity player_entity = registry.players.entities.front();
-	TransformComponent& playerTransformComponent = registry.transforms.get(player_entity);
-	TransformComponent& enemyTransformComponent = registry.transforms.get(enemy_entity);
+	auto& playerTransformComponent = registry.transforms.get(player_entity);
+	auto& enemyTransformComponent = registry.transforms.get(enemy_entity);
 	VisionComponent& visionComponent = registry.visionComponents.get(enemy_entity);
 	vec2 relativePosition = abs(playerTransformComponent.position - enemyTransformComponent.position);
 	float sightRadius = visionComponent.sightRadius;
 	if (visionComponent.hasAggro) {
+		// once it has seen the player it keeps following, even around corners
 		if (relativePosition.y < sightRadius * 1.25 && relativePosition.x < sightRadius * 1.5) {
 			return true;
 		}
 		visionComponent.hasAggro = false;
 	}
 	else {
-		if (relativePosition.y < sightRadius && relativePosition.x < sightRadius) {
+		// has to actually see the player first, not through walls
+		if (relativePosition.y < sightRadius && relativePosition.x < sightRadius
+			&& HasLineOfSight(*levelGrid, enemyTransformComponent.position, playerTransformComponent.position)) {
+			visionComponent.hasAggro = true;
 			return true;
 		}
-		visionComponent.hasAggro = true;
 	}
 
 	return false;
 }
 
-void AISystem::Init(std::vector<std::vector<int>> newLevelTiles) {
-	levelTiles = newLevelTiles;
+void AISystem::Init(std::shared_ptr<const TileGrid> newLevelGrid) {
+	levelGrid = std::move(newLevelGrid);
+	std::shared_ptr<NavGrid> grid = NavGrid::FromTileGrid(levelGrid);
+	WalkerMovement walker;
+	walker.jumpSpeed = enemyJumpSpeed / TILE_SIZE;
+	walker.gravity = enemyGravity / TILE_SIZE;
+	walker.maxMoveSpeed = enemyMaxMoveSpeed / TILE_SIZE;
+	walker.climbsLadders = false; // see the ladder climbing left out of EnemyJumping
+	grid->BuildPlatforms(walker);
+	navGrid = grid;
+	pathRequests.SetGrid(navGrid);
 }
 
-// Manhattan distance heuristic for heuristic search
-float AISystem::Heuristic(vec2 startPos, vec2 goalPos) {
-	return abs(startPos[0] - goalPos[0]) + abs(startPos[1] - goalPos[1]);
-}
 
 void AISystem::EnemyJumping(Entity enemy_entity, float deltaTime) {
 	registry.motions.get(enemy_entity).acceleration.y = enemyGravity;
@@ -782,37 +761,29 @@ void AISystem::EnemyJumping(Entity enemy_entity, float deltaTime) {
 	if (walkingBehavior.stupid) {
 		return;
 	}
-	MotionComponent& enemyMotion = registry.motions.get(enemy_entity);
+	auto& enemyMotion = registry.motions.get(enemy_entity);
 	bool bGrounded = false;
 	bool bStillLaddered = false;
 	bool bCollidedDirectlyAbove = false;
 	bool bJumpingAndAscending = enemyMotion.velocity.y < 0.f;
 
-	std::vector<CollisionEvent> enemyRelevantCollisions;
 	std::vector<CollisionEvent> groundableCollisions;
 	std::vector<CollisionEvent> directlyAboveCollisions;
 
+	// Only this enemy's own contacts, they sit together in the contact buffer
+	const ContactBuffer::Range enemyContacts = registry.contacts(enemy_entity);
+
 	// Check if grounded or colliding above
-	const auto& collisionsRegistry = registry.collisionEvents;
-	for (u32 i = 0; i < collisionsRegistry.components.size(); ++i)
+	for (const CollisionEvent& colEvent : enemyContacts)
 	{
-		const CollisionEvent colEvent = collisionsRegistry.components[i];
-		Entity entity = collisionsRegistry.entities[i];
 		Entity entity_other = colEvent.other;
 
-		if (entity.GetTagAndID() != enemy_entity.GetTagAndID())
-		{
-			continue;
-		}
-
 		if (entity_other.GetTag() == TAG_PLAYERBLOCKABLE)
 		{
-			enemyRelevantCollisions.push_back(colEvent);
-
-			CollisionComponent& enemyCollider = registry.colliders.get(entity);
+			auto& enemyCollider = registry.colliders.get(enemy_entity);
 
 			// Note(Kevin): this second collision check redundant right now but may become needed later - keep for now?
-			CollisionInfo collisionCheck = CheckCollision(enemyCollider, registry.colliders.get(entity_other));
+			CollisionInfo collisionCheck = CheckCollision(enemyCollider, TileCollider(colEvent));
 			if (collisionCheck.collides && abs(collisionCheck.collision_overlap.y) < abs(collisionCheck.collision_overlap.x))
 			{
 				if (collisionCheck.collision_overlap.y <= 0.f
@@ -854,9 +825,10 @@ void AISystem::EnemyJumping(Entity enemy_entity, float deltaTime) {
 	{
 		for (auto gcol : groundableCollisions)
 		{
-			for (auto pcol : enemyRelevantCollisions)
+			for (const CollisionEvent& pcol : enemyContacts)
 			{
-				if (gcol.collision_overlap.x == pcol.collision_overlap.x
+				if (pcol.other.GetTag() == TAG_PLAYERBLOCKABLE
+					&& gcol.collision_overlap.x == pcol.collision_overlap.x
 					&& gcol.collision_overlap.y != pcol.collision_overlap.y)
 				{
 					/* Check we aren't in a wall */
@@ -871,9 +843,10 @@ void AISystem::EnemyJumping(Entity enemy_entity, float deltaTime) {
 	{
 		for (auto acol : directlyAboveCollisions)
 		{
-			for (auto pcol : enemyRelevantCollisions)
+			for (const CollisionEvent& pcol : enemyContacts)
 			{
-				if (acol.collision_overlap.x == pcol.collision_overlap.x
+				if (pcol.other.GetTag() == TAG_PLAYERBLOCKABLE
+					&& acol.collision_overlap.x == pcol.collision_overlap.x
 					&& acol.collision_overlap.y != pcol.collision_overlap.y)
 				{
 					/* Check we aren't in a wall */
@@ -940,8 +913,8 @@ void AISystem::BossStep(float elapsedTime) {
 	}
 	Boss& bossComponent = registry.boss.components[0];
 	VisionComponent& bossVisual = registry.visionComponents.get(bossEntity);
-	TransformComponent& bossTransform = registry.transforms.get(bossEntity);
-	TransformComponent& playerTransform = registry.transforms.get(registry.players.entities[0]);
+	auto& bossTransform = registry.transforms.get(bossEntity);
+	auto& playerTransform = registry.transforms.get(registry.players.entities[0]);
 	vec2 distance = bossTransform.position - playerTransform.position;
 	if ((abs(distance.x) < bossVisual.sightRadius && abs(distance.y) < bossVisual.sightRadius) || bossVisual.hasAggro) {
 		// ACTIONTICK is an indicator of HOW MANY ACTIONS are LEFT in the state
@@ -1074,8 +1047,8 @@ void AISystem::BossStep(float elapsedTime) {
 	Entity& bossEntity   = registry.boss.entities[0];
 	Boss& bossComponent  = registry.boss.components[0];
 	VisionComponent& bossVisual = registry.visionComponents.get(bossEntity);
-	TransformComponent& bossTransform = registry.transforms.get(bossEntity);
-	TransformComponent& playerTransform = registry.transforms.get(registry.players.entities[0]);
+	auto& bossTransform = registry.transforms.get(bossEntity);
+	auto& playerTransform = registry.transforms.get(registry.players.entities[0]);
 	vec2 distance = bossTransform.position - playerTransform.position;
 	if ((distance.x < bossVisual.sightRadius && distance.y < bossVisual.sightRadius) || bossVisual.hasAggro) {
 		// "Second Phase" stuff
@@ -1245,8 +1218,7 @@ void AISystem::bossMeleeAttack(Entity bossEntity, Boss bossComponent, TransformC
 	collider.collider_position = transform.position;
 }
 
-void AISystem::rangedTransformation(Entity& bossEntity, Boss& bossComponent, TransformComponent& bossTransform) {
-	registry.sprites.remove(bossEntity);
+void AISystem::rangedTransformation(Entity& bossEntity, Boss& bossComponent, TransformComponent::Ref& bossTransform) {
 	vec2 dimensions = { 45, 42 };
 	vec2 collisionDimension = { 30, 40 };
 	auto& collider = registry.colliders.get(bossEntity);
@@ -1259,8 +1231,9 @@ void AISystem::rangedTransformation(Entity& bossEntity, Boss& bossComponent, Tra
 	else {
 		bossTransform.center = { 28, 22 };
 	}
-	auto& sprite = registry.sprites.insert(
-		bossEntity,
+	// Swap the sprite in place, removing it would take the boss out of the movingSprites group and move bossTransform
+	auto& sprite = registry.sprites.get(bossEntity);
+	sprite = SpriteComponent
 		{
 				dimensions,
 				4,
@@ -1304,14 +1277,13 @@ void AISystem::rangedTransformation(Entity& bossEntity, Boss& bossComponent, Tra
 		},
 
 },
-		}
-	);
+		};
 	sprite.reverse = bossComponent.facingRight;
 	sprite.selected_animation = 1;
+	registry.sprites.mark_changed(bossEntity); // new texture, the render key has to be rebuilt
 }
 
-void AISystem::meleeTransformation(Entity& bossEntity, Boss& bossComponent, TransformComponent& bossTransform) {
-	registry.sprites.remove(bossEntity);
+void AISystem::meleeTransformation(Entity& bossEntity, Boss& bossComponent, TransformComponent::Ref& bossTransform) {
 	vec2 dimensions = { 108, 59 };
 	vec2 collisionDimension = { 30, 45 };
 	auto& collider = registry.colliders.get(bossEntity);
@@ -1324,8 +1296,9 @@ void AISystem::meleeTransformation(Entity& bossEntity, Boss& bossComponent, Tran
 	else {
 		bossTransform.center = { 72, 34 };
 	}
-	auto& sprite = registry.sprites.insert(
-		bossEntity,
+	// Swap the sprite in place, removing it would take the boss out of the movingSprites group and move bossTransform
+	auto& sprite = registry.sprites.get(bossEntity);
+	sprite = SpriteComponent
 		{
 				dimensions,
 				4,
@@ -1370,8 +1343,8 @@ void AISystem::meleeTransformation(Entity& bossEntity, Boss& bossComponent, Tran
 		},
 
 },
-		}
-	);
+		};
 	sprite.reverse = bossComponent.facingRight;
 	sprite.selected_animation = 1;
+	registry.sprites.mark_changed(bossEntity); // new texture, the render key has to be rebuilt
 }
@@ -8,25 +8,32 @@
 #include "common.hpp"
 #include "world_init.hpp"
 #include "physics_system.hpp"
+#include "pathfinding.hpp"
 
 
 class AISystem
 {
 public:
 	void Step(float deltaTime);
+	void PathingStep(float deltaTime);
 	void HandleSpriteSheetFrame(float deltaTime);
 	void EnemyAttack(Entity enemy_entity, float elapsedTime);
 	void Pathfind(Entity enemy_entity, float elapsedTime);
 	void EnemyJumping(Entity enemy_entity, float deltaTime);
 	bool PlayerInAwarenessBubble(Entity enemy_entity);
 	void PathBehavior(Entity enemy_entity);
+	void ApplyPathResult(const PathResult& result);
 	void PatrolBehavior(Entity enemy_entity, float elapsedTime);
-	void Init(std::vector<std::vector<int>> levelTiles);
-	float Heuristic(vec2 pos1, vec2 pos2);
+	void Init(std::shared_ptr<const TileGrid> levelGrid);
 	void BossStep(float deltaTime);
+	void PrintStats();
+	// Non-zero: that many non-urgent thinks per tick and waited path results, instead of the time budget
+	void SetLockstep(u32 thinksPerTick);
 private:
+	void ScheduleThinking(float elapsedTime);
+	void Think(Entity enemy_entity, float elapsedTime);
 	void bossProjectileAttack(Entity, Boss, TransformComponent, TransformComponent);
 	void bossMeleeAttack(Entity, Boss, TransformComponent, TransformComponent);
-	void rangedTransformation(Entity&, Boss&, TransformComponent&);
-	void meleeTransformation(Entity&, Boss&, TransformComponent&);
+	void rangedTransformation(Entity&, Boss&, TransformComponent::Ref&);
+	void meleeTransformation(Entity&, Boss&, TransformComponent::Ref&);
 };
\ No newline at end of file
@@ -0,0 +1,589 @@
+#include "benchmarks.hpp"
+#include "console.hpp"
+#include "tiny_ecs.hpp"
+#include "job_system.hpp"
+#include "pathfinding.hpp"
+#include "tile_grid.hpp"
+#include "spatial_hash.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+using BenchClock = std::chrono::high_resolution_clock;
+
+INTERNAL float MicrosecondsSince(BenchClock::time_point start)
+{
+    return (float)std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count() / 1000.f;
+}
+
+// The ComponentContainer as it was before the sparse set: entity -> index goes through an unordered_map.
+// Only kept around so bench_ecs has something to compare against.
+template <typename Component>
+class HashedComponentContainer
+{
+    std::unordered_map<unsigned int, unsigned int> map_entity_componentID;
+public:
+    std::vector<Component> components;
+    std::vector<Entity> entities;
+
+    Component& insert(Entity e, Component c)
+    {
+        map_entity_componentID[e.GetID()] = (unsigned int)components.size();
+        components.push_back(std::move(c));
+        entities.push_back(e);
+        return components.back();
+    }
+
+    Component& get(Entity e) { return components[map_entity_componentID[e.GetID()]]; }
+
+    bool has(Entity e) { return map_entity_componentID.count(e.GetID()) > 0; }
+
+    void remove(Entity e)
+    {
+        if (has(e))
+        {
+            int cID = map_entity_componentID[e.GetID()];
+            components[cID] = std::move(components.back());
+            entities[cID] = entities.back();
+            map_entity_componentID[entities.back().GetID()] = cID;
+            map_entity_componentID.erase(e.GetID());
+            components.pop_back();
+            entities.pop_back();
+        }
+    }
+};
+
+// Roughly the size of the hot components (TransformComponent is 7 floats)
+struct BenchComponent
+{
+    vec2 a = { 0.f, 0.f };
+    vec2 b = { 1.f, 1.f };
+    vec2 c = { 0.f, 0.f };
+    float d = 0.f;
+};
+
+struct ContainerTimings
+{
+    float insert = 0.f;
+    float get = 0.f;     // random order lookups of entities that are in the container
+    float has = 0.f;     // lookups of entities that are NOT in the container
+    float iterate = 0.f; // walk the entity array and get() each one, like MoveEntities / Draw do
+    float remove = 0.f;
+};
+
+template <typename Container>
+INTERNAL ContainerTimings TimeContainer(const std::vector<Entity>& inside, const std::vector<Entity>& outside, const std::vector<Entity>& shuffled)
+{
+    ContainerTimings t;
+    Container container;
+    volatile float sink = 0.f;
+
+    auto start = BenchClock::now();
+    for (Entity e : inside)
+        container.insert(e, BenchComponent());
+    t.insert = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    for (Entity e : shuffled)
+        sink = sink + container.get(e).d;
+    t.get = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    u32 found = 0;
+    for (Entity e : outside)
+        found += container.has(e) ? 1 : 0;
+    t.has = MicrosecondsSince(start);
+    sink = sink + (float)found;
+
+    start = BenchClock::now();
+    for (u32 i = 0; i < (u32)container.entities.size(); ++i)
+    {
+        BenchComponent& c = container.get(container.entities[i]);
+        c.a += c.b;
+    }
+    t.iterate = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    for (Entity e : shuffled)
+        container.remove(e);
+    t.remove = MicrosecondsSince(start);
+
+    return t;
+}
+
+INTERNAL void PrintTimings(const char* name, u32 count, const ContainerTimings& t)
+{
+    float n = (float)count;
+    console_printf("  %-8s insert %6.1f  get %6.1f  has(miss) %6.1f  iterate %6.1f  remove %6.1f  (ns/op)\n",
+        name, t.insert * 1000.f / n, t.get * 1000.f / n, t.has * 1000.f / n, t.iterate * 1000.f / n, t.remove * 1000.f / n);
+}
+
+INTERNAL void BenchmarkComponentContainers()
+{
+    const u32 counts[] = { 1000, 10000, 100000 };
+    std::default_random_engine rng(1337);
+
+    for (u32 count : counts)
+    {
+        // Every other entity goes into the container so the miss lookups hit IDs in the same range
+        std::vector<Entity> inside;
+        std::vector<Entity> outside;
+        inside.reserve(count);
+        outside.reserve(count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            inside.push_back(Entity::CreateEntity());
+            outside.push_back(Entity::CreateEntity());
+        }
+        std::vector<Entity> shuffled = inside;
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+        ContainerTimings hashed = TimeContainer<HashedComponentContainer<BenchComponent>>(inside, outside, shuffled);
+        ContainerTimings sparse = TimeContainer<ComponentContainer<BenchComponent>>(inside, outside, shuffled);
+
+        console_printf("%u entities:\n", count);
+        PrintTimings("hashmap", count, hashed);
+        PrintTimings("sparse", count, sparse);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            Entity::DestroyEntity(inside[i]);
+            Entity::DestroyEntity(outside[i]);
+        }
+    }
+}
+
+// Two more component types so a View / OwningGroup has three different containers to join
+template <int N>
+struct BenchPart
+{
+    vec2 v = { 1.f, 1.f };
+};
+
+// Walking three containers together: View looks the other two up per entity, OwningGroup just indexes them
+INTERNAL void BenchmarkJointIteration()
+{
+    const u32 count = 10000;
+    std::default_random_engine rng(1337);
+
+    std::vector<Entity> all;
+    for (u32 i = 0; i < count; ++i)
+        all.push_back(Entity::CreateEntity());
+
+    ComponentContainer<BenchComponent> a;
+    ComponentContainer<BenchPart<1>> b;
+    ComponentContainer<BenchPart<2>> c;
+    // Insert in different orders and leave some entities out, like sprites / transforms / motions in a level
+    std::vector<Entity> order = all;
+    std::shuffle(order.begin(), order.end(), rng);
+    for (u32 i = 0; i < count; ++i) a.insert(order[i], BenchComponent());
+    std::shuffle(order.begin(), order.end(), rng);
+    for (u32 i = 0; i < count; ++i) if (i % 4 != 0) b.insert(order[i], BenchPart<1>());
+    std::shuffle(order.begin(), order.end(), rng);
+    for (u32 i = 0; i < count; ++i) c.insert(order[i], BenchPart<2>());
+
+    volatile float sink = 0.f;
+    u32 viewCount = 0;
+    auto start = BenchClock::now();
+    View<BenchComponent, BenchPart<1>, BenchPart<2>>(a, b, c).each([&](Entity e, BenchComponent& x, BenchPart<1>& y, BenchPart<2>& z) {
+        x.a += y.v + z.v;
+        ++viewCount;
+    });
+    float viewTime = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    OwningGroup<BenchComponent, BenchPart<1>, BenchPart<2>> group(a, b, c);
+    float buildTime = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    group.each([&](Entity e, BenchComponent& x, BenchPart<1>& y, BenchPart<2>& z) {
+        x.a += y.v + z.v;
+    });
+    float groupTime = MicrosecondsSince(start);
+    sink = sink + a.components[0].a.x;
+
+    // in-place sort of a container outside the group
+    std::shuffle(order.begin(), order.end(), rng);
+    ComponentContainer<BenchComponent> sorted;
+    for (Entity e : order) sorted.insert(e, BenchComponent());
+    start = BenchClock::now();
+    sorted.sort([](Entity l, Entity r) { return l.GetID() < r.GetID(); });
+    float sortTime = MicrosecondsSince(start);
+
+    console_printf("joint iteration of %u / %u entities with 3 components:\n", viewCount, count);
+    console_printf("  view   %8.1f us\n  group  %8.1f us  (building the group %.1f us)\n", viewTime, groupTime, buildTime);
+    console_printf("sort %u components in place: %.1f us\n", count, sortTime);
+
+    for (Entity e : all)
+        Entity::DestroyEntity(e);
+}
+
+// The same per-element work once on the calling thread and once through parallel_for
+INTERNAL void BenchmarkParallelFor()
+{
+    const u32 count = 100000;
+    std::vector<BenchComponent> items(count);
+    auto integrate = [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i)
+        {
+            BenchComponent& c = items[i];
+            for (int step = 0; step < 16; ++step)
+            {
+                c.b += c.c * 0.016f;
+                c.a += c.b * 0.016f;
+                c.d += std::sqrt(c.a.x * c.a.x + c.a.y * c.a.y);
+            }
+        }
+    };
+
+    auto start = BenchClock::now();
+    integrate(0, count);
+    float serialTime = MicrosecondsSince(start);
+
+    start = BenchClock::now();
+    parallel_for(count, 1024, integrate);
+    float parallelTime = MicrosecondsSince(start);
+
+    console_printf("%u elements, %u workers + main thread:\n", count, job_system_worker_count());
+    console_printf("  serial   %8.1f us\n  parallel %8.1f us\n", serialTime, parallelTime);
+}
+
+// A stage sized grid with a solid border and a quarter of the rest solid at random
+INTERNAL std::shared_ptr<TileGrid> RandomTileGrid(int width, int height, std::default_random_engine& rng)
+{
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::shared_ptr<TileGrid> tiles = std::make_shared<TileGrid>();
+    tiles->Reset(width, height, 16.f);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            if (x == 0 || y == 0 || x == width - 1 || y == height - 1 || percent(rng) < 25)
+                tiles->Add(x, y, TILE_SOLID);
+    return tiles;
+}
+
+// Searches between random free tiles of a level sized grid (55x45) with random walls
+INTERNAL void BenchmarkPathfinding()
+{
+    const int width = 55;
+    const int height = 45;
+    std::default_random_engine rng(1337);
+    std::shared_ptr<NavGrid> grid = NavGrid::FromTileGrid(RandomTileGrid(width, height, rng));
+
+    // Same jump as the walking enemies in ai_system.cpp, in tiles
+    WalkerMovement walker;
+    walker.jumpSpeed = 125.f / 16.f;
+    walker.gravity = 250.f / 16.f;
+    walker.maxMoveSpeed = 64.f / 16.f;
+    auto graphStart = BenchClock::now();
+    grid->BuildPlatforms(walker);
+    console_printf("platform graph: %u spans and %u links for %u tiles, built in %.2f us\n", (u32)grid->platforms.spans.size(),
+        (u32)grid->platforms.links.size(), grid->width * grid->height, MicrosecondsSince(graphStart));
+
+    std::vector<vec2> freeTiles;
+    for (int x = 0; x < width; ++x)
+        for (int y = 0; y < height; ++y)
+            if (grid->IsFree(x, y))
+                freeTiles.push_back(vec2((float)x, (float)y));
+    std::uniform_int_distribution<size_t> pick(0, freeTiles.size() - 1);
+
+    const u32 count = 1000;
+    const PathAgent agents[] = { PATH_AGENT_FLYING, PATH_AGENT_WALKING };
+    for (PathAgent agent : agents)
+    {
+        u32 found = 0;
+        u64 expanded = 0;
+        u64 length = 0;
+        auto start = BenchClock::now();
+        for (u32 i = 0; i < count; ++i)
+        {
+            PathResult result = FindPath(*grid, { Entity(), agent, freeTiles[pick(rng)], freeTiles[pick(rng)] });
+            found += result.found ? 1 : 0;
+            expanded += result.nodesExpanded;
+            length += result.pathLength;
+        }
+        float time = MicrosecondsSince(start);
+        console_printf("%s: %u searches on %dx%d, %.2f us each, %u found, %.0f nodes expanded and path length %.1f on average\n",
+            agent == PATH_AGENT_FLYING ? "flying" : "walking", count, width, height, time / (float)count, found,
+            (float)expanded / (float)count, found ? (float)length / (float)found : 0.f);
+    }
+
+    // One flow field answers every flying enemy at once, its cost doesn't depend on how many there are
+    FlowField field;
+    auto start = BenchClock::now();
+    for (u32 i = 0; i < 100; ++i)
+    {
+        vec2 goal = freeTiles[pick(rng)];
+        field.Build(*grid, (int)goal.x, (int)goal.y);
+    }
+    float buildTime = MicrosecondsSince(start) / 100.f;
+    u32 steps = 0;
+    start = BenchClock::now();
+    for (u32 i = 0; i < count; ++i)
+    {
+        vec2 from = freeTiles[pick(rng)];
+        vec2 direction;
+        steps += field.NextStep((int)from.x, (int)from.y, direction) ? 1 : 0;
+    }
+    float lookupTime = MicrosecondsSince(start);
+    console_printf("flow field: %.2f us to build, %u lookups in %.2f us (%u had a step)\n", buildTime, count, lookupTime, steps);
+}
+
+// Line of sight between random points about as far apart as an enemy's sight radius, the query enemy
+// vision and ranged attacks make for every enemy every frame
+INTERNAL void BenchmarkLineOfSight()
+{
+    const int width = 55;
+    const int height = 45;
+    std::default_random_engine rng(1337);
+    std::shared_ptr<TileGrid> tiles = RandomTileGrid(width, height, rng);
+    std::uniform_real_distribution<float> coordinate(16.f, 16.f * (width - 1));
+    std::uniform_real_distribution<float> offset(-200.f, 200.f);
+
+    const u32 count = 100000;
+    std::vector<vec2> from(count), to(count);
+    for (u32 i = 0; i < count; ++i)
+    {
+        from[i] = vec2(coordinate(rng), coordinate(rng) * (float)height / (float)width);
+        to[i] = from[i] + vec2(offset(rng), offset(rng));
+    }
+
+    u32 visible = 0;
+    auto start = BenchClock::now();
+    for (u32 i = 0; i < count; ++i)
+        visible += HasLineOfSight(*tiles, from[i], to[i]) ? 1 : 0;
+    float time = MicrosecondsSince(start);
+    console_printf("line of sight: %u queries up to 280 px on %dx%d, %.3f us each, %u clear\n", count, width, height, time / (float)count, visible);
+}
+
+// CheckAllCollisions' job on a full stage: 500 bodies scattered over the free tiles all look for what they
+// touch. Once with a collider on every solid tile with an open face, scanning every collider with the
+// distance check it used to do and then through the broadphase, and once with only the bodies in the
+// broadphase and the level answered by the tile grid, the way it is done now.
+INTERNAL void BenchmarkCollisions()
+{
+    const int width = 55;
+    const int height = 45;
+    const float tileSize = 16.f;
+    std::default_random_engine rng(1337);
+    std::shared_ptr<TileGrid> tiles = RandomTileGrid(width, height, rng);
+
+    std::vector<vec2> mins, maxs, centers;
+    std::vector<vec2> freeTiles;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            vec2 center((x + 0.5f) * tileSize, (y + 0.5f) * tileSize);
+            if (!tiles->IsSolid(x, y))
+                freeTiles.push_back(center);
+            else if (tiles->IsFree(x - 1, y) || tiles->IsFree(x + 1, y) || tiles->IsFree(x, y - 1) || tiles->IsFree(x, y + 1))
+            {
+                centers.push_back(center);
+                mins.push_back(center - vec2(tileSize * 0.5f));
+                maxs.push_back(center + vec2(tileSize * 0.5f));
+            }
+        }
+    const u32 tileColliders = (u32)centers.size();
+
+    const u32 bodyCount = 500;
+    std::uniform_int_distribution<size_t> pick(0, freeTiles.size() - 1);
+    std::uniform_real_distribution<float> jitter(-8.f, 8.f);
+    for (u32 i = 0; i < bodyCount; ++i)
+    {
+        vec2 center = freeTiles[pick(rng)] + vec2(jitter(rng), jitter(rng));
+        centers.push_back(center);
+        mins.push_back(center - vec2(6.f, 8.f));
+        maxs.push_back(center + vec2(6.f, 8.f));
+    }
+    const u32 count = (u32)centers.size();
+
+    auto overlaps = [&](u32 a, u32 b)
+    {
+        return mins[a].x < maxs[b].x && maxs[a].x > mins[b].x && mins[a].y < maxs[b].y && maxs[a].y > mins[b].y;
+    };
+
+    const u32 steps = 100;
+    u64 bruteTested = 0, bruteColliding = 0;
+    auto start = BenchClock::now();
+    for (u32 step = 0; step < steps; ++step)
+        for (u32 body = tileColliders; body < count; ++body)
+            for (u32 other = 0; other < count; ++other)
+            {
+                if (length(centers[body] - centers[other]) > 64.f || other == body)
+                    continue;
+                ++bruteTested;
+                bruteColliding += overlaps(body, other) ? 1 : 0;
+            }
+    float bruteTime = MicrosecondsSince(start) / (float)steps;
+
+    SpatialHash hash(32.f);
+    u64 hashTested = 0, hashColliding = 0;
+    float buildTime = 0.f;
+    start = BenchClock::now();
+    for (u32 step = 0; step < steps; ++step)
+    {
+        auto buildStart = BenchClock::now();
+        hash.Build(mins.data(), maxs.data(), count);
+        buildTime += MicrosecondsSince(buildStart);
+        for (u32 body = tileColliders; body < count; ++body)
+            hash.Query(mins[body], maxs[body], [&](u32 other)
+            {
+                if (other == body)
+                    return;
+                ++hashTested;
+                hashColliding += overlaps(body, other) ? 1 : 0;
+            });
+    }
+    float hashTime = MicrosecondsSince(start) / (float)steps;
+
+    u64 gridTested = 0, gridColliding = 0;
+    start = BenchClock::now();
+    for (u32 step = 0; step < steps; ++step)
+    {
+        hash.Build(mins.data() + tileColliders, maxs.data() + tileColliders, bodyCount);
+        for (u32 body = tileColliders; body < count; ++body)
+        {
+            hash.Query(mins[body], maxs[body], [&](u32 other)
+            {
+                other += tileColliders;
+                if (other == body)
+                    return;
+                ++gridTested;
+                gridColliding += overlaps(body, other) ? 1 : 0;
+            });
+            for (int y = tiles->TileY(mins[body].y); y <= tiles->TileY(maxs[body].y); ++y)
+                for (int x = tiles->TileX(mins[body].x); x <= tiles->TileX(maxs[body].x); ++x)
+                {
+                    if (!tiles->IsSolid(x, y)
+                        || !(tiles->IsFree(x - 1, y) || tiles->IsFree(x + 1, y) || tiles->IsFree(x, y - 1) || tiles->IsFree(x, y + 1)))
+                        continue;
+                    ++gridTested;
+                    vec2 tileMin(x * tileSize, y * tileSize);
+                    gridColliding += (mins[body].x < tileMin.x + tileSize && maxs[body].x > tileMin.x
+                                      && mins[body].y < tileMin.y + tileSize && maxs[body].y > tileMin.y) ? 1 : 0;
+                }
+        }
+    }
+    float gridTime = MicrosecondsSince(start) / (float)steps;
+
+    console_printf("collisions: %u bodies and %u tile colliders on %dx%d, per step:\n", bodyCount, tileColliders, width, height);
+    console_printf("  every collider: %.1f us, %llu pairs tested, %llu colliding\n", bruteTime,
+        (unsigned long long)(bruteTested / steps), (unsigned long long)(bruteColliding / steps));
+    console_printf("  broadphase:     %.1f us (%.1f us building it), %llu pairs tested, %llu colliding\n", hashTime, buildTime / (float)steps,
+        (unsigned long long)(hashTested / steps), (unsigned long long)(hashColliding / steps));
+    console_printf("  tile grid:      %.1f us, %llu pairs and tiles tested, %llu colliding\n", gridTime,
+        (unsigned long long)(gridTested / steps), (unsigned long long)(gridColliding / steps));
+}
+
+// Arrows shot level through a stage at the tick rates a slow machine falls back to. Moved a step at a time and
+// checked where they end up, an arrow that gets more than half its height into a wall in one step is pushed out
+// over or under it instead of stopping. Swept, every one of them stops at the first wall in its way.
+INTERNAL void BenchmarkSweeps()
+{
+    const int width = 55;
+    const int height = 45;
+    const float tileSize = 16.f;
+    std::default_random_engine rng(1337);
+    std::shared_ptr<TileGrid> tiles = RandomTileGrid(width, height, rng);
+
+    std::vector<vec2> freeTiles;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            if (!tiles->IsSolid(x, y))
+                freeTiles.push_back(vec2((x + 0.5f) * tileSize, (y + 0.5f) * tileSize));
+
+    // createArrow's box, shot at itemShootSideVelocity
+    const u32 count = 1000;
+    const vec2 halfSize(8.f, 4.f);
+    const float speed = 250.f;
+    std::uniform_int_distribution<size_t> pick(0, freeTiles.size() - 1);
+    std::uniform_int_distribution<int> side(0, 1);
+    std::vector<vec2> starts(count), velocities(count);
+    for (u32 i = 0; i < count; ++i)
+    {
+        starts[i] = freeTiles[pick(rng)];
+        velocities[i] = vec2(side(rng) ? speed : -speed, 0.f);
+    }
+
+    console_printf("arrows: %u shot at %.0f px/s on %dx%d, how many stop at the first wall:\n", count, speed, width, height);
+    const float tickRates[] = { 120.f, 30.f, 10.f };
+    for (float tickRate : tickRates)
+    {
+        const float tickSeconds = 1.f / tickRate;
+        const u32 maxSteps = (u32)(2.f * tickRate);
+
+        u32 discreteWalls = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+            vec2 position = starts[i];
+            bool stopped = false;
+            for (u32 step = 0; step < maxSteps && !stopped; ++step)
+            {
+                position += velocities[i] * tickSeconds;
+                const vec2 boxMin = position - halfSize;
+                const vec2 boxMax = position + halfSize;
+                for (int y = tiles->TileY(boxMin.y); y <= tiles->TileY(boxMax.y) && !stopped; ++y)
+                    for (int x = tiles->TileX(boxMin.x); x <= tiles->TileX(boxMax.x) && !stopped; ++x)
+                    {
+                        if (!tiles->IsSolid(x, y))
+                            continue;
+                        // CheckCollisionWithBlockable resolves along the smaller overlap
+                        const float overlapX = std::min(boxMax.x, (x + 1) * tileSize) - std::max(boxMin.x, x * tileSize);
+                        const float overlapY = std::min(boxMax.y, (y + 1) * tileSize) - std::max(boxMin.y, y * tileSize);
+                        discreteWalls += overlapX < overlapY ? 1 : 0;
+                        stopped = true;
+                    }
+            }
+        }
+
+        u32 sweptWalls = 0;
+        u32 sweeps = 0;
+        auto start = BenchClock::now();
+        for (u32 i = 0; i < count; ++i)
+        {
+            vec2 position = starts[i];
+            const vec2 displacement = velocities[i] * tickSeconds;
+            for (u32 step = 0; step < maxSteps; ++step)
+            {
+                ++sweeps;
+                TileSweepHit hit;
+                if (SweepTiles(*tiles, position - halfSize, position + halfSize, displacement, hit))
+                {
+                    sweptWalls += hit.normal.x != 0.f ? 1 : 0;
+                    break;
+                }
+                position += displacement;
+            }
+        }
+        float sweptTime = MicrosecondsSince(start);
+
+        console_printf("  %4.0f Hz: discrete %u, swept %u (%.3f us per sweep)\n", tickRate, discreteWalls, sweptWalls, sweptTime / (float)sweeps);
+    }
+}
+
+void RegisterBenchmarkCommands()
+{
+    get_console().bind_cmd("bench_ecs",
+        [](std::istream& is, std::ostream& os){
+            BenchmarkComponentContainers();
+            BenchmarkJointIteration();
+        });
+    get_console().bind_cmd("bench_path",
+        [](std::istream& is, std::ostream& os){
+            BenchmarkPathfinding();
+        });
+    get_console().bind_cmd("bench_los",
+        [](std::istream& is, std::ostream& os){
+            BenchmarkLineOfSight();
+        });
+    get_console().bind_cmd("bench_physics",
+        [](std::istream& is, std::ostream& os){
+            BenchmarkCollisions();
+            BenchmarkSweeps();
+        });
+    get_console().bind_cmd("bench_jobs",
+        [](std::istream& is, std::ostream& os){
+            BenchmarkParallelFor();
+        });
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "common.hpp"
+
+// Console commands that time engine internals in isolation (type "bench_ecs" etc. in the console).
+// Results are printed to the console.
+void RegisterBenchmarkCommands();
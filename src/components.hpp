@@ -248,6 +248,7 @@ struct Enemy
 {
     float projectile_speed = 100.f;
     float playerHurtCooldown = 0.f;
+    float thinkIdleMs = 0.f; // since the AI scheduler last let this enemy think, see AISystem::ScheduleThinking
     //std::vector<Behavior> behaviors;
 };
 
@@ -378,12 +379,75 @@ struct ActivePlayerProjectile {
     float damage = 0.f;
 };
 
+// Outlives the stage it was created in: ECSRegistry::clear_stage leaves these entities alone and destroys the
+// rest. Nothing is tagged yet, the player is re-created every stage and gets its lasting components copied over.
+struct Persistent {
+};
+
+// Moves fast enough to get through a tile in one step (arrows, thrown weapons, enemy projectiles): PhysicsSystem
+// sweeps its box along the whole move instead of only checking where it ends up
+struct FastMover {
+};
+
+// Transform, Motion and Collision are stored struct-of-arrays (see SoAStorage in tiny_ecs.hpp) because
+// MoveEntities and the collision checks stream a couple of their fields for every moving entity / collider.
+// Get them as auto& (or TransformComponent::Ref&), a plain TransformComponent is only a copy.
+// When adding a field, add its column to push_back / pop_back / clear / reserve / for_each_column and to Ref.
 struct TransformComponent
 {
     vec2 position = { 0.f, 0.f };
     vec2 scale = { 1.f, 1.f };
     vec2 center = { 0.f, 0.f }; // offset from "top-left". If a sprite has dimensions 16x16, then center of 8x8 points to center of sprite
     float rotation = 0.f;
+
+    struct Columns
+    {
+        std::vector<vec2> position;
+        std::vector<vec2> scale;
+        std::vector<vec2> center;
+        std::vector<float> rotation;
+
+        void push_back(const TransformComponent& c)
+        {
+            position.push_back(c.position);
+            scale.push_back(c.scale);
+            center.push_back(c.center);
+            rotation.push_back(c.rotation);
+        }
+        void pop_back() { position.pop_back(); scale.pop_back(); center.pop_back(); rotation.pop_back(); }
+        void clear() { position.clear(); scale.clear(); center.clear(); rotation.clear(); }
+        void reserve(size_t n) { position.reserve(n); scale.reserve(n); center.reserve(n); rotation.reserve(n); }
+        template <typename Func> void for_each_column(Func f) { f(position); f(scale); f(center); f(rotation); }
+    };
+
+    struct Ref
+    {
+        vec2& position;
+        vec2& scale;
+        vec2& center;
+        float& rotation;
+
+        Ref(Columns& c, size_t i) : position(c.position[i]), scale(c.scale[i]), center(c.center[i]), rotation(c.rotation[i]) {}
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref& o) { return *this = (TransformComponent)o; }
+        Ref& operator=(const TransformComponent& o)
+        {
+            position = o.position;
+            scale = o.scale;
+            center = o.center;
+            rotation = o.rotation;
+            return *this;
+        }
+        operator TransformComponent() const
+        {
+            TransformComponent t;
+            t.position = position;
+            t.scale = scale;
+            t.center = center;
+            t.rotation = rotation;
+            return t;
+        }
+    };
 };
 
 // All data relevant to the motion of entities
@@ -394,6 +458,61 @@ struct MotionComponent
     vec2 drag = { 0.f, 0.f };                   // unsigned
     vec2 terminalVelocity = { 9999.f, 9999.f }; // unsigned
     bool facingRight = true;
+
+    struct Columns
+    {
+        std::vector<vec2> velocity;
+        std::vector<vec2> acceleration;
+        std::vector<vec2> drag;
+        std::vector<vec2> terminalVelocity;
+        std::vector<SoABool> facingRight;
+
+        void push_back(const MotionComponent& c)
+        {
+            velocity.push_back(c.velocity);
+            acceleration.push_back(c.acceleration);
+            drag.push_back(c.drag);
+            terminalVelocity.push_back(c.terminalVelocity);
+            facingRight.push_back({ c.facingRight });
+        }
+        void pop_back() { velocity.pop_back(); acceleration.pop_back(); drag.pop_back(); terminalVelocity.pop_back(); facingRight.pop_back(); }
+        void clear() { velocity.clear(); acceleration.clear(); drag.clear(); terminalVelocity.clear(); facingRight.clear(); }
+        void reserve(size_t n) { velocity.reserve(n); acceleration.reserve(n); drag.reserve(n); terminalVelocity.reserve(n); facingRight.reserve(n); }
+        template <typename Func> void for_each_column(Func f) { f(velocity); f(acceleration); f(drag); f(terminalVelocity); f(facingRight); }
+    };
+
+    struct Ref
+    {
+        vec2& velocity;
+        vec2& acceleration;
+        vec2& drag;
+        vec2& terminalVelocity;
+        bool& facingRight;
+
+        Ref(Columns& c, size_t i) : velocity(c.velocity[i]), acceleration(c.acceleration[i]), drag(c.drag[i]),
+                                    terminalVelocity(c.terminalVelocity[i]), facingRight(c.facingRight[i].value) {}
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref& o) { return *this = (MotionComponent)o; }
+        Ref& operator=(const MotionComponent& o)
+        {
+            velocity = o.velocity;
+            acceleration = o.acceleration;
+            drag = o.drag;
+            terminalVelocity = o.terminalVelocity;
+            facingRight = o.facingRight;
+            return *this;
+        }
+        operator MotionComponent() const
+        {
+            MotionComponent m;
+            m.velocity = velocity;
+            m.acceleration = acceleration;
+            m.drag = drag;
+            m.terminalVelocity = terminalVelocity;
+            m.facingRight = facingRight;
+            return m;
+        }
+    };
 };
 
 struct CollisionComponent
@@ -402,6 +521,50 @@ struct CollisionComponent
     // Collision
     vec2 collision_pos = { 0, 0 }; // Collision box x,y size in the positive direction from the center
     vec2 collision_neg = { 0, 0 }; // Collision box x,y size in the negative direction from the center
+
+    struct Columns
+    {
+        std::vector<vec2> collider_position;
+        std::vector<vec2> collision_pos;
+        std::vector<vec2> collision_neg;
+
+        void push_back(const CollisionComponent& c)
+        {
+            collider_position.push_back(c.collider_position);
+            collision_pos.push_back(c.collision_pos);
+            collision_neg.push_back(c.collision_neg);
+        }
+        void pop_back() { collider_position.pop_back(); collision_pos.pop_back(); collision_neg.pop_back(); }
+        void clear() { collider_position.clear(); collision_pos.clear(); collision_neg.clear(); }
+        void reserve(size_t n) { collider_position.reserve(n); collision_pos.reserve(n); collision_neg.reserve(n); }
+        template <typename Func> void for_each_column(Func f) { f(collider_position); f(collision_pos); f(collision_neg); }
+    };
+
+    struct Ref
+    {
+        vec2& collider_position;
+        vec2& collision_pos;
+        vec2& collision_neg;
+
+        Ref(Columns& c, size_t i) : collider_position(c.collider_position[i]), collision_pos(c.collision_pos[i]), collision_neg(c.collision_neg[i]) {}
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref& o) { return *this = (CollisionComponent)o; }
+        Ref& operator=(const CollisionComponent& o)
+        {
+            collider_position = o.collider_position;
+            collision_pos = o.collision_pos;
+            collision_neg = o.collision_neg;
+            return *this;
+        }
+        operator CollisionComponent() const
+        {
+            CollisionComponent c;
+            c.collider_position = collider_position;
+            c.collision_pos = collision_pos;
+            c.collision_neg = collision_neg;
+            return c;
+        }
+    };
 };
 
 struct VisionComponent
@@ -484,6 +647,11 @@ struct CollisionEvent
     vec2 collision_overlap = {0, 0};
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
+	// Level tiles have no entity or collider of their own (see PhysicsSystem): for those 'other' is a null
+	// entity that only carries the tile's tag, and this is which tile it was
+	bool isTile = false;
+	i32 tileX = 0;
+	i32 tileY = 0;
 	CollisionEvent(Entity& other) { this->other = other; };
 };
 
@@ -88,6 +88,7 @@ INTERNAL Entity createArrow(vec2 position)
 
     registry.playerProjectiles.emplace(entity);
     registry.activePlayerProjectiles.emplace(entity);
+    registry.fastMovers.emplace(entity);
 
     registry.sprites.insert(
             entity,
@@ -145,7 +146,11 @@ INTERNAL void ResolvePickUp(HolderComponent& holderComponent, Entity holder)
             item.collidableWithEnvironment = false;
             item.grounded = false;
 
-            MotionComponent& motion = registry.motions.get(held_weapon);
+            if (registry.fastMovers.has(held_weapon)) {
+                registry.fastMovers.remove(held_weapon);
+            }
+
+            auto& motion = registry.motions.get(held_weapon);
             motion.velocity = {0.f, 0.f};
             motion.acceleration = {0.f, 0.f};
         }
@@ -153,7 +158,7 @@ INTERNAL void ResolvePickUp(HolderComponent& holderComponent, Entity holder)
     holderComponent.near_weapon = Entity();
 }
 
-INTERNAL void ResolveDrop(HolderComponent& holderComponent, MotionComponent& holderMotion)
+INTERNAL void ResolveDrop(HolderComponent& holderComponent, MotionComponent::Ref& holderMotion)
 {
     if(holderComponent.want_to_drop && holderComponent.held_weapon.GetTagAndID() != 0)
     {
@@ -163,7 +168,7 @@ INTERNAL void ResolveDrop(HolderComponent& holderComponent, MotionComponent& hol
         item.collidableWithEnvironment = true;
         item.grounded = false;
 
-        MotionComponent& motion = registry.motions.get(held_weapon);
+        auto& motion = registry.motions.get(held_weapon);
         motion.acceleration.y = itemGravity;
 
         if (held_weapon.GetTag() == TAG_WALKINGBOMB)
@@ -172,7 +177,7 @@ INTERNAL void ResolveDrop(HolderComponent& holderComponent, MotionComponent& hol
             sprite.selected_animation = 1;
             sprite.current_frame = 0;
 
-            MotionComponent& bombMotion = registry.motions.get(held_weapon);
+            auto& bombMotion = registry.motions.get(held_weapon);
 
             if (holderMotion.facingRight) {
                 bombMotion.velocity.x = bombWalkVelocity;
@@ -191,7 +196,7 @@ INTERNAL void ResolveDrop(HolderComponent& holderComponent, MotionComponent& hol
     }
 }
 
-INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent& holderMotion)
+INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent::Ref& holderMotion)
 {
     if(holderComponent.want_to_throw && holderComponent.near_weapon.GetTagAndID() == 0 && holderComponent.held_weapon.GetTagAndID() != 0)
     {
@@ -201,7 +206,7 @@ INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent& ho
         item.collidableWithEnvironment = true;
         item.grounded = false;
 
-        MotionComponent& motion = registry.motions.get(held_weapon);
+        auto& motion = registry.motions.get(held_weapon);
         motion.acceleration.y = itemGravity;
 
         if (registry.weapons.has(held_weapon) && !registry.weapons.get(held_weapon).ranged && !registry.activePlayerProjectiles.has(held_weapon))
@@ -215,7 +220,7 @@ INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent& ho
             sprite.selected_animation = 1;
             sprite.current_frame = 0;
 
-            MotionComponent& bombMotion = registry.motions.get(held_weapon);
+            auto& bombMotion = registry.motions.get(held_weapon);
 
             if (holderMotion.facingRight) {
                 bombMotion.velocity.x = bombWalkVelocity;
@@ -224,6 +229,10 @@ INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent& ho
             }
         }
         else {
+            if (!registry.fastMovers.has(held_weapon))
+            {
+                registry.fastMovers.emplace(held_weapon);
+            }
             if(holderMotion.facingRight)
             {
                 motion.velocity = {itemThrowSideVelocity, itemNormalYVelocity};
@@ -248,7 +257,7 @@ INTERNAL void ResolveThrow(HolderComponent& holderComponent, MotionComponent& ho
     }
 }
 
-void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComponent& holderMotion, TransformComponent& holderTransform)
+void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComponent::Ref& holderMotion, TransformComponent::Ref& holderTransform)
 {
     if (!holderComponent.want_to_melee && !holderComponent.want_to_shoot)
     {
@@ -263,7 +272,7 @@ void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComp
         item.collidableWithEnvironment = true;
         item.grounded = false;
 
-        MotionComponent& motion = registry.motions.get(held_weapon);
+        auto& motion = registry.motions.get(held_weapon);
         motion.acceleration.y = itemGravity;
 
         holderComponent.carried_items.erase(holderComponent.carried_items.begin() + holderComponent.current_item);
@@ -273,7 +282,7 @@ void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComp
         sprite.selected_animation = 1;
         sprite.current_frame = 0;
 
-        MotionComponent& bombMotion = registry.motions.get(held_weapon);
+        auto& bombMotion = registry.motions.get(held_weapon);
 
         if (holderMotion.facingRight) {
             bombMotion.velocity.x = bombWalkVelocity;
@@ -302,12 +311,9 @@ void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComp
 
             weapon.cooldown = bowCooldown;
 
-            Entity projectile;
-
             switch (held_weapon.GetTag()) {
                 case (TAG_BOW):
                 {
-                    projectile = createArrow(holderTransform.position);
                     SpriteComponent& sprite = registry.sprites.get(held_weapon);
                     sprite.selected_animation = 0;
                     sprite.animations[0].played = false;
@@ -323,33 +329,43 @@ void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComp
                 }
             }
 
-            Item& item = registry.items.get(projectile);
-            item.collidableWithEnvironment = true;
-            item.grounded = false;
-
-            MotionComponent& motion = registry.motions.get(projectile);
-            motion.acceleration.y = itemGravity;
-
+            vec2 velocity;
+            bool reverse;
             if(holderMotion.facingRight)
             {
-                motion.velocity = {itemShootSideVelocity, itemNormalYVelocity};
-                registry.sprites.get(projectile).reverse = false;
+                velocity = {itemShootSideVelocity, itemNormalYVelocity};
+                reverse = false;
             }
             else
             {
-                motion.velocity = {-itemShootSideVelocity, itemNormalYVelocity};
-                registry.sprites.get(projectile).reverse = true;
+                velocity = {-itemShootSideVelocity, itemNormalYVelocity};
+                reverse = true;
             }
             if (holderComponent.want_to_shoot_up)
             {
-                motion.velocity.x *= 0.7;
-                motion.velocity.y = itemUpwardsYVelocity;
+                velocity.x *= 0.7;
+                velocity.y = itemUpwardsYVelocity;
             } else if (holderComponent.want_to_shoot_down)
             {
-                motion.velocity.x *= 0.7;
-                motion.velocity.y = itemDownwardsYVelocity;
+                velocity.x *= 0.7;
+                velocity.y = itemDownwardsYVelocity;
             }
 
+            // Spawned at the end of the frame so the holder loop isn't iterating containers that grow under it
+            vec2 position = holderTransform.position;
+            registry.create_deferred([position, velocity, reverse]() {
+                Entity projectile = createArrow(position);
+
+                Item& item = registry.items.get(projectile);
+                item.collidableWithEnvironment = true;
+                item.grounded = false;
+
+                auto& motion = registry.motions.get(projectile);
+                motion.acceleration.y = itemGravity;
+                motion.velocity = velocity;
+                registry.sprites.get(projectile).reverse = reverse;
+            });
+
         }
         else if (holderComponent.want_to_melee && !weapon.ranged)
         {
@@ -372,7 +388,7 @@ void ItemHolderSystem::ResolveShoot(HolderComponent& holderComponent, MotionComp
     holderComponent.want_to_melee = false;
 }
 
-INTERNAL void ResolveItemMovement(HolderComponent& holderComponent, MotionComponent& holderMotion, TransformComponent& holderTransform)
+INTERNAL void ResolveItemMovement(HolderComponent& holderComponent, MotionComponent::Ref& holderMotion, TransformComponent::Ref& holderTransform)
 {
     if (holderComponent.current_item < 0) {
         holderComponent.held_weapon = Entity();
@@ -382,7 +398,7 @@ INTERNAL void ResolveItemMovement(HolderComponent& holderComponent, MotionCompon
     holderComponent.held_weapon = holderComponent.carried_items.at(holderComponent.current_item);
 
     Entity weapon = holderComponent.held_weapon;
-    TransformComponent& weaponTransform = registry.transforms.get(weapon);
+    auto& weaponTransform = registry.transforms.get(weapon);
     weaponTransform.position = holderTransform.position;
     if(holderMotion.facingRight)
     {
@@ -421,13 +437,8 @@ INTERNAL void ResolveCycle(HolderComponent& holderComponent)
 
 void ItemHolderSystem::Step(float deltaTime)
 {
-    std::vector<Entity> holders = registry.holders.entities;
-    for(Entity holder : holders)
+    registry.view<HolderComponent, MotionComponent, TransformComponent>().each([&](Entity holder, HolderComponent& holderComponent, MotionComponent::Ref& holderMotion, TransformComponent::Ref& holderTransform)
     {
-        HolderComponent& holderComponent = registry.holders.get(holder);
-        MotionComponent& holderMotion = registry.motions.get(holder);
-        TransformComponent& holderTransform = registry.transforms.get(holder);
-
         if (holderComponent.held_weapon.GetTagAndID() != 0)
         {
             Entity held_weapon = holderComponent.held_weapon;
@@ -445,5 +456,5 @@ void ItemHolderSystem::Step(float deltaTime)
         ResolveShoot(holderComponent, holderMotion, holderTransform);
         ResolveCycle(holderComponent);
         ResolveItemMovement(holderComponent, holderMotion, holderTransform);
-    }
+    });
 }
@@ -14,7 +14,7 @@ public:
     void Init(WorldSystem *world_sys_arg);
 
 private:
-    void ResolveShoot(HolderComponent& holderComponent, MotionComponent& holderMotion, TransformComponent& holderTransform);
+    void ResolveShoot(HolderComponent& holderComponent, MotionComponent::Ref& holderMotion, TransformComponent::Ref& holderTransform);
 
     WorldSystem* world;
 };
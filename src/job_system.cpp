@@ -0,0 +1,212 @@
+#include "job_system.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A chunk of a parallel_for (func + range), or a submitted job that owns its function (task)
+struct Job
+{
+    const std::function<void(u32, u32)>* func = nullptr;
+    std::function<void()> task;
+    u32 begin = 0;
+    u32 end = 0;
+    std::atomic<u32>* remaining = nullptr;
+};
+
+// One per thread. The owner pushes and pops at the back, thieves take from the front.
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+INTERNAL std::vector<std::thread> workers;
+INTERNAL std::unique_ptr<JobQueue[]> queues; // [0] belongs to the main thread, [1..] to the workers
+INTERNAL u32 queueCount = 0;
+INTERNAL std::atomic<bool> running(false);
+INTERNAL std::atomic<u32> queuedJobs(0);
+INTERNAL std::mutex sleepMutex;
+INTERNAL std::condition_variable wakeWorkers;
+
+INTERNAL thread_local u32 ownQueue = 0;
+
+INTERNAL bool PopOrSteal(u32 self, Job& out)
+{
+    {
+        JobQueue& own = queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            out = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            --queuedJobs;
+            return true;
+        }
+    }
+    for (u32 i = 1; i < queueCount; ++i)
+    {
+        JobQueue& victim = queues[(self + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            out = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            --queuedJobs;
+            return true;
+        }
+    }
+    return false;
+}
+
+INTERNAL void RunJob(Job& job)
+{
+    if (job.func)
+        (*job.func)(job.begin, job.end);
+    else
+        job.task();
+    job.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+INTERNAL void WorkerLoop(u32 index)
+{
+    ownQueue = index;
+    while (running)
+    {
+        Job job;
+        if (PopOrSteal(index, job))
+        {
+            RunJob(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeWorkers.wait(lock, []{ return !running || queuedJobs > 0; });
+    }
+}
+
+void job_system_initialize(u32 workerCount)
+{
+    if (running)
+        return;
+    if (workerCount == 0)
+    {
+        u32 hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    queueCount = workerCount + 1;
+    queues.reset(new JobQueue[queueCount]);
+    running = true;
+    for (u32 i = 1; i < queueCount; ++i)
+        workers.emplace_back(WorkerLoop, i);
+}
+
+void job_system_shutdown()
+{
+    if (!running)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+
+    // Whatever is still queued runs here, so nobody waits forever on a submitted job
+    for (u32 i = 0; i < queueCount; ++i)
+        for (Job& job : queues[i].jobs)
+            RunJob(job);
+    queues.reset();
+    queueCount = 0;
+}
+
+u32 job_system_worker_count()
+{
+    return (u32)workers.size();
+}
+
+u32 job_system_thread_index()
+{
+    return ownQueue;
+}
+
+INTERNAL void WakeWorkers()
+{
+    {
+        // Taking the lock orders the push before a worker that is about to sleep checks queuedJobs
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeWorkers.notify_all();
+}
+
+void job_submit(std::function<void()> func, std::atomic<u32>& pending)
+{
+    if (!running || workers.empty())
+    {
+        func();
+        return;
+    }
+
+    ++pending;
+    Job job;
+    job.task = std::move(func);
+    job.remaining = &pending;
+    {
+        // Into a worker's queue, the submitting thread usually has other things to do than picking it up itself
+        LOCAL_PERSIST std::atomic<u32> nextQueue(0);
+        JobQueue& queue = queues[1 + nextQueue++ % (queueCount - 1)];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+        ++queuedJobs;
+    }
+    WakeWorkers();
+}
+
+void job_wait(std::atomic<u32>& pending)
+{
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+        Job job;
+        if (running && PopOrSteal(ownQueue, job))
+            RunJob(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void parallel_for(u32 count, u32 chunkSize, const std::function<void(u32, u32)>& func)
+{
+    if (chunkSize == 0)
+        chunkSize = 1;
+    const u32 chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (!running || workers.empty() || chunkCount <= 1)
+    {
+        if (count > 0)
+            func(0, count);
+        return;
+    }
+
+    // Deal the chunks out round robin so every worker starts with something, stealing evens out the rest
+    std::atomic<u32> remaining(chunkCount);
+    for (u32 chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        Job job;
+        job.func = &func;
+        job.begin = chunk * chunkSize;
+        job.end = job.begin + chunkSize < count ? job.begin + chunkSize : count;
+        job.remaining = &remaining;
+
+        JobQueue& queue = queues[(ownQueue + chunk) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+        ++queuedJobs;
+    }
+    WakeWorkers();
+    job_wait(remaining);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <functional>
+
+/**
+
+    WORK-STEALING JOB SYSTEM
+
+    A fixed pool of worker threads. Every thread (the workers and the main thread) has its own queue of jobs:
+    it takes its newest job first, and when its queue is empty it steals the oldest job of another thread.
+    Whoever waits on a batch of jobs helps running them instead of sleeping, so a parallel_for on the
+    main thread uses the main thread as well.
+
+    Jobs must not touch the registry structurally (insert / remove / create_deferred / destroy_deferred),
+    see ECSRegistry::parallel_for_each.
+
+*/
+
+// 0 workers = one per hardware thread, minus the main thread
+void job_system_initialize(u32 workerCount = 0);
+void job_system_shutdown();
+u32 job_system_worker_count();
+// 0 on the main thread, 1.. on the workers
+u32 job_system_thread_index();
+
+// Queues func and returns right away. 'pending' goes up by one now and back down once func has run, so it can
+// be polled (or waited on with job_wait) by whoever owns the work. Runs func inline if the job system isn't running.
+void job_submit(std::function<void()> func, std::atomic<u32>& pending);
+// Helps running queued jobs until 'pending' is 0
+void job_wait(std::atomic<u32>& pending);
+
+// Splits [0, count) into chunks of 'chunkSize' and calls func(begin, end) for each chunk across the threads.
+// Returns once every chunk is done. Runs inline if the job system isn't running or there is only one chunk.
+void parallel_for(u32 count, u32 chunkSize, const std::function<void(u32, u32)>& func);
@@ -6,18 +6,10 @@
 #include "common.hpp"
 #include "world_init.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "tile_grid.hpp"
 
 INTERNAL GAMELEVELENUM __currentStage;
 
-INTERNAL void AddTileSizedCollider(Entity tileEntity)
-{
-    auto& transform = registry.transforms.get(tileEntity);
-    auto& collider = registry.colliders.emplace(tileEntity);
-    collider.collision_neg = { 0, 0 };
-    collider.collision_pos = { TILE_SIZE, TILE_SIZE };
-    collider.collider_position = transform.position;
-}
-
 INTERNAL Entity CreateBasicLevelTile(i32 column, i32 row, u16 spriteFrame = 0)
 {
     Entity entity = Entity::CreateEntity(TAG_PLAYERBLOCKABLE);
@@ -123,8 +115,6 @@ INTERNAL Entity CreateDecoration(i32 column, i32 row, bool standing = true)
         }
     );
 
-    AddTileSizedCollider(entity);
-
     return entity;
 }
 
@@ -157,8 +147,6 @@ INTERNAL Entity CreateLadderTile(i32 column, i32 row)
         }
     );
 
-    AddTileSizedCollider(entity);
-
     return entity;
 }
 
@@ -194,11 +182,6 @@ INTERNAL Entity CreateSpikeTile(i32 col, i32 row)
         }
     );
 
-    auto& collider = registry.colliders.emplace(entity); // TODO
-    collider.collider_position = transform.position;
-    collider.collision_neg = { 0, 0 };
-    collider.collision_pos = { 6, 8 };
-
     return entity;
 }
 
@@ -231,8 +214,6 @@ INTERNAL Entity CreateEndPointTile(i32 col, i32 row)
         }
     );
 
-    AddTileSizedCollider(entity);
-
     ProximityTextComponent& newText = registry.proximityTexts.emplace(entity);
     newText.triggerPosition = transform.position + vec2(TILE_SIZE/2.f, TILE_SIZE/2.f);
     newText.triggerRadius = 12.f;
@@ -406,7 +387,15 @@ struct CurrentLevelData
 };
 INTERNAL CurrentLevelData currentLevelData;
 
-INTERNAL std::vector<std::vector<Entity>> levelTiles;
+// Flags of every tile of the stage, handed out read-only through GetLevelGrid
+INTERNAL std::shared_ptr<TileGrid> levelGrid = std::make_shared<TileGrid>();
+// The entity of each solid tile, row-major like levelGrid, for giving the tiles their sprites
+INTERNAL std::vector<Entity> levelTileEntities;
+
+std::shared_ptr<const TileGrid> GetLevelGrid()
+{
+    return levelGrid;
+}
 
 INTERNAL void ClearCurrentLevelData()
 {
@@ -418,15 +407,19 @@ INTERNAL void ClearCurrentLevelData()
     currentLevelData.shopItemSpawns.clear();
 }
 
-INTERNAL void ClearLevelTiles()
+// A fresh grid for every stage, systems still holding on to the last one keep it as it was
+INTERNAL void ClearLevelTiles(u32 width, u32 height)
 {
-    for (int i = 0; i < levelTiles.size(); ++i)
-    {
-        for (int j = 0; j < levelTiles[0].size(); ++j)
-        {
-            levelTiles[i][j] = Entity();
-        }
-    }
+    levelGrid = std::make_shared<TileGrid>();
+    levelGrid->Reset(width, height, TILE_SIZE);
+    levelTileEntities.assign(width * height, Entity());
+}
+
+INTERNAL void AddSolidLevelTile(i32 col, i32 row, u16 spriteFrame = 0)
+{
+    Entity tile = CreateBasicLevelTile(col, row, spriteFrame);
+    levelGrid->Add(col, row, TILE_SOLID);
+    levelTileEntities[row * levelGrid->width + col] = tile;
 }
 
 INTERNAL void ParseRoomData(const ns::RoomRawData r, int roomXIndex, int roomYIndex)
@@ -446,15 +439,13 @@ INTERNAL void ParseRoomData(const ns::RoomRawData r, int roomXIndex, int roomYIn
             switch (c)
             {
                 case 'A': {
-                    Entity tile = CreateBasicLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
-                    levelTiles[roomXIndex * r.width + j][roomYIndex * r.height + i] = tile;
+                    AddSolidLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
                 }break;
                 case 'C': {
                     u8 roll = rand() % 2;
                     if (roll == 0)
                     {
-                        Entity tile = CreateBasicLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
-                        levelTiles[roomXIndex * r.width + j][roomYIndex * r.height + i] = tile;
+                        AddSolidLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
                     }
                 }break;
 
@@ -542,6 +533,7 @@ INTERNAL void ParseRoomData(const ns::RoomRawData r, int roomXIndex, int roomYIn
                 case '2': {
                     // end point
                     CreateEndPointTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
+                    levelGrid->Add(roomXIndex * r.width + j, roomYIndex * r.height + i, TILE_ENDPOINT);
                 }break;
 
                 case 'X': {
@@ -552,19 +544,19 @@ INTERNAL void ParseRoomData(const ns::RoomRawData r, int roomXIndex, int roomYIn
                 case 'L': {
                     // ladder
                     CreateLadderTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
+                    levelGrid->Add(roomXIndex * r.width + j, roomYIndex * r.height + i, TILE_LADDER);
                 }break;
 
                 case 'W': {
                     // spikes
                     CreateSpikeTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
+                    levelGrid->Add(roomXIndex * r.width + j, roomYIndex * r.height + i, TILE_SPIKE);
                 }break;
 
                 case 'B': {
                     // wooden tiles
-                    // Entity tile = CreateBasicLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i, 6);
-                    // levelTiles[roomXIndex * r.width + j][roomYIndex * r.height + i] = tile;
-                    Entity tile = CreateBasicLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
-                    levelTiles[roomXIndex * r.width + j][roomYIndex * r.height + i] = tile;
+                    // AddSolidLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i, 6);
+                    AddSolidLevelTile(roomXIndex * r.width + j, roomYIndex * r.height + i);
                 }break;
 
                 default: {
@@ -582,15 +574,15 @@ INTERNAL void ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(Entity e,
         return;
     }
 
-    bool topClear = (row - 1 >= 0 && (col >= 0 && col < levelTiles.size())) && levelTiles[col][row - 1] == 0;
-    bool botClear = (row + 1 < levelTiles[0].size() && (col >= 0 && col < levelTiles.size())) && levelTiles[col][row + 1] == 0;
-    bool leftClear = (col - 1 >= 0 && (row >= 0 && row < levelTiles[0].size())) && levelTiles[col - 1][row] == 0;
-    bool rightClear = (col + 1 < levelTiles.size() && (row >= 0 && row < levelTiles[0].size())) && levelTiles[col + 1][row] == 0;
+    bool topClear = levelGrid->IsFree(col, row - 1);
+    bool botClear = levelGrid->IsFree(col, row + 1);
+    bool leftClear = levelGrid->IsFree(col - 1, row);
+    bool rightClear = levelGrid->IsFree(col + 1, row);
 
-    bool tlCornerClear = (row - 1 >= 0 && col - 1 >= 0) && levelTiles[col - 1][row - 1] == 0;
-    bool trCornerClear = (row - 1 >= 0 && col + 1 < levelTiles.size()) && levelTiles[col + 1][row - 1] == 0;
-    bool blCornerClear = (row + 1 < levelTiles[0].size() && col - 1 >= 0) && levelTiles[col - 1][row + 1] == 0;
-    bool brCornerClear = (row + 1 < levelTiles[0].size() && col + 1 < levelTiles.size()) && levelTiles[col + 1][row + 1] == 0;
+    bool tlCornerClear = levelGrid->IsFree(col - 1, row - 1);
+    bool trCornerClear = levelGrid->IsFree(col + 1, row - 1);
+    bool blCornerClear = levelGrid->IsFree(col - 1, row + 1);
+    bool brCornerClear = levelGrid->IsFree(col + 1, row + 1);
 
     if (topClear && botClear && leftClear && rightClear)
     {
@@ -712,111 +704,23 @@ INTERNAL void ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(Entity e,
     }
 }
 
-INTERNAL void AddColliderIfRequired(Entity tileEntity, i32 col, i32 row)
-{
-    bool topClear = row - 1 >= 0 && levelTiles[col][row - 1] == 0;
-    bool botClear = row + 1 < levelTiles[0].size() && levelTiles[col][row + 1] == 0;
-    bool leftClear = col - 1 >= 0 && levelTiles[col - 1][row] == 0;
-    bool rightClear = col + 1 < levelTiles.size() && levelTiles[col + 1][row] == 0;
-    bool atLeastOneFaceIsClear = topClear || botClear || leftClear || rightClear;
-    if (atLeastOneFaceIsClear)
-    {
-        AddTileSizedCollider(tileEntity);
-    }
-}
-
 /** Process and ready the level for gameplay.
  *  Change sprites for top or bottom tiles.
- *  Add colliders to tiles that can be collided with. */
-INTERNAL void UpdateLevelGeometry(GAMELEVELENUM stageToGenerate)
+ *  Tiles have no colliders, the physics system collides with the level grid directly. */
+INTERNAL void UpdateLevelGeometry()
 {
-    switch(stageToGenerate)
+    // Column by column, the decorations roll their dice in this order
+    for (int col = 0; col < (int)levelGrid->width; ++col)
     {
-        case CHAPTER_TUTORIAL:
-        {
-            for (int col = 0; col < tutorialRoomData.width; ++col)
-            {
-                for (int row = 0; row < tutorialRoomData.height; ++row)
-                {
-                    Entity e = levelTiles[col][row];
-                    if (e != 0)
-                    {
-                        ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
-                        AddColliderIfRequired(e, col, row);
-                    }
-                }
-            }
-            break;
-        }
-        case CHAPTER_BOSS:
+        for (int row = 0; row < (int)levelGrid->height; ++row)
         {
-            for (int col = 0; col < bossRoomData.width; ++col)
+            Entity e = levelTileEntities[row * levelGrid->width + col];
+            if (e.GetID() != 0)
             {
-                for (int row = 0; row < bossRoomData.height; ++row)
-                {
-                    Entity e = levelTiles[col][row];
-                    if (e != 0)
-                    {
-                        ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
-                        AddColliderIfRequired(e, col, row);
-                    }
-                }
+                ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
             }
-            break;
-        }
-
-        case CHAPTER_ONE_STAGE_ONE:
-        {
-            for (int col = 0; col < NUMTILESWIDE; ++col)
-            {
-                for (int row = 0; row < NUMTILESTALL; ++row)
-                {
-                    Entity e = levelTiles[col][row];
-                    if (e != 0)
-                    {
-                        ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
-                        AddColliderIfRequired(e, col, row);
-                    }
-                }
-            }
-            break;
-        }
-
-        case CHAPTER_TWO_STAGE_ONE:
-        {
-            for (int col = 0; col < NUMTILESWIDE; ++col)
-            {
-                for (int row = 0; row < NUMTILESTALL; ++row)
-                {
-                    Entity e = levelTiles[col][row];
-                    if (e != 0)
-                    {
-                        ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
-                        AddColliderIfRequired(e, col, row);
-                    }
-                }
-            }
-            break;
-        }
-
-        case CHAPTER_THREE_STAGE_ONE:
-        {
-            for (int col = 0; col < NUMTILESWIDE; ++col)
-            {
-                for (int row = 0; row < NUMTILESTALL; ++row)
-                {
-                    Entity e = levelTiles[col][row];
-                    if (e != 0)
-                    {
-                        ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(e, col, row);
-                        AddColliderIfRequired(e, col, row);
-                    }
-                }
-            }
-            break;
         }
     }
-    
 }
 
 INTERNAL void GenerateRooms(std::unordered_map<std::string, std::vector<ns::RoomRawData>> currentChapterRooms)
@@ -909,7 +813,6 @@ INTERNAL void GenerateRooms(std::unordered_map<std::string, std::vector<ns::Room
 
 INTERNAL void GenerateNewLevel(GAMELEVELENUM stageToGenerate)
 {
-    ClearLevelTiles();
     ClearCurrentLevelData();
     __currentStage = stageToGenerate;
 
@@ -930,30 +833,18 @@ INTERNAL void GenerateNewLevel(GAMELEVELENUM stageToGenerate)
     {
         case CHAPTER_TUTORIAL:
         {
-            levelTiles.resize(tutorialRoomData.width);
-            for(auto& ltv : levelTiles)
-            {
-                ltv.resize(tutorialRoomData.height);
-            }
+            ClearLevelTiles(tutorialRoomData.width, tutorialRoomData.height);
         }break;
 
         case CHAPTER_BOSS: {
-            levelTiles.resize(bossRoomData.width);
-            for (auto& ltv : levelTiles)
-            {
-                ltv.resize(bossRoomData.height);
-            }
+            ClearLevelTiles(bossRoomData.width, bossRoomData.height);
         }break;
 
         case CHAPTER_ONE_STAGE_ONE:
         case CHAPTER_TWO_STAGE_ONE:
         case CHAPTER_THREE_STAGE_ONE:
         {
-            levelTiles.resize(NUMTILESWIDE);
-            for(auto& ltv : levelTiles)
-            {
-                ltv.resize(NUMTILESTALL);
-            }
+            ClearLevelTiles(NUMTILESWIDE, NUMTILESTALL);
         }break;
     }
 
@@ -973,17 +864,16 @@ INTERNAL void GenerateNewLevel(GAMELEVELENUM stageToGenerate)
     }
 
     // Process and prepare the level
-    UpdateLevelGeometry(stageToGenerate);
+    UpdateLevelGeometry();
 
     if(stageToGenerate == CHAPTER_ONE_STAGE_ONE)
     {
-        // Boundary
+        // Boundary, solid as far as physics is concerned through the grid's border
+        levelGrid->solidBorder = true;
         for (int i = -1; i < ((NUMTILESWIDE)+1); ++i)
         {
             auto _a = CreateBasicLevelTile(i, -1);
             auto _b = CreateBasicLevelTile(i, NUMTILESTALL);
-            AddTileSizedCollider(_a);
-            AddTileSizedCollider(_b);
             ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(_a, i, -1);
             ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(_b, i, NUMTILESTALL);
         }
@@ -991,8 +881,6 @@ INTERNAL void GenerateNewLevel(GAMELEVELENUM stageToGenerate)
         {
             auto _a = CreateBasicLevelTile(-1, i);
             auto _b = CreateBasicLevelTile(NUMTILESWIDE, i);
-            AddTileSizedCollider(_a);
-            AddTileSizedCollider(_b);
             ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(_a, -1, i);
             ChangeSpritesBasedOnSurroundingTilesAndCreateDecorations(_b, NUMTILESWIDE, i);
         }
@@ -1003,14 +891,14 @@ INTERNAL void GenerateNewLevel(GAMELEVELENUM stageToGenerate)
 
     int minx = (-1 * TILE_SIZE);
     int miny = (-1 * TILE_SIZE);
-    int maxx = (int)levelTiles.size()+1;
-    int maxy = (int)levelTiles[0].size()+1;
+    int maxx = (int)levelGrid->width+1;
+    int maxy = (int)levelGrid->height+1;
     if(stageToGenerate == CHAPTER_TUTORIAL || stageToGenerate == CHAPTER_BOSS)
     {
         minx = 0;
         miny = 0;
-        maxx = (int)levelTiles.size();
-        maxy = (int)levelTiles[0].size();
+        maxx = (int)levelGrid->width;
+        maxy = (int)levelGrid->height;
     }
     currentLevelData.cameraBoundMin.x = minx + halfWidth;
     currentLevelData.cameraBoundMin.y = miny + halfHeight;
@@ -21,6 +21,9 @@
 #include "sprite_system.hpp"
 #include "ui_system.hpp"
 #include "console.hpp"
+#include "benchmarks.hpp"
+#include "job_system.hpp"
+#include "task_graph.hpp"
 //#include "timer.h"
 
 #define TINY_ECS_LIB_IMPLEMENTATION
@@ -169,8 +172,42 @@ int main(int argc, char* argv[])
 
     LoadFont(&g_font_handle_c64, &g_font_atlas_c64, font_path("SourceCodePro.ttf").c_str(), 20, false); //CONSOLE_TEXT_SIZE
     console_initialize(&g_font_handle_c64, g_font_atlas_c64, &renderer);
-
-	// Variable timestep loop
+    RegisterBenchmarkCommands();
+    job_system_initialize();
+
+    // The in-game systems of a frame, rebuilt every frame from what each system says it touches
+    TaskGraph frameTasks;
+    get_console().bind_cmd("tasks",
+        [&frameTasks](std::istream& is, std::ostream& os){
+            frameTasks.report();
+        });
+    get_console().bind_cmd("physics_stats",
+        [&physics](std::istream& is, std::ostream& os){
+            physics.PrintStats();
+        });
+
+    // The game advances in fixed ticks no matter the frame rate. The AI still reads the clock by default: it thinks
+    // until a time budget is spent and applies walker path results on the first tick that finds them done, so runs
+    // can differ. "ai_lockstep <n>" takes the clock out of both, making the same inputs play out the same way.
+    // "tick_rate <hz>" in the console changes the rate, e.g. a lower one on slow machines.
+    float tickSeconds = 1.f / 120.f;
+    get_console().bind_cmd("tick_rate",
+        [&tickSeconds](std::istream& is, std::ostream& os){
+            float hz = 0.f;
+            if(is >> hz && hz >= 10.f && hz <= 1000.f)
+            {
+                tickSeconds = 1.f / hz;
+            }
+            console_printf("simulation runs at %.0f ticks per second\n", 1.f / tickSeconds);
+        });
+    // Catch-up limits: a frame adds at most maxFrameSeconds of game time (longer stalls, like loading a stage,
+    // are dropped) and runs at most maxTicksPerFrame ticks. If that can't keep up, the game slows down
+    // instead of spending ever longer catching up.
+    const float maxFrameSeconds = 0.1f;
+    const int maxTicksPerFrame = 8;
+    float tickAccumulator = 0.f;
+
+	// Fixed timestep loop
 	auto t = Clock::now();
 	while (!world.is_over()) {
         //printf("swap window: %f seconds\n", timer::timestamp());
@@ -182,59 +219,88 @@ int main(int argc, char* argv[])
 		auto now = Clock::now();
 		float elapsed_ms = (float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000.f;
 		t = now;
-        float deltaTime = elapsed_ms / 1000.f; // elapsed time in SECONDS
-        if(deltaTime > 0.1f) { continue; } // if delta time is too large, will cause glitches
+        float frameSeconds = elapsed_ms / 1000.f; // elapsed time in SECONDS
         float currentTimeInSeconds = (float)(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / 1000.0);
         renderer.currentTimeInSeconds = currentTimeInSeconds;
 
-        if(console_is_hidden())
+        tickAccumulator += min(frameSeconds, maxFrameSeconds);
+        int ticksThisFrame = 0;
+        while(tickAccumulator >= tickSeconds && ticksThisFrame < maxTicksPerFrame)
         {
-            if(GlobalPauseForSeconds > 0.f || world.gamePaused)
-            {
-                if(!world.gamePaused) { GlobalPauseForSeconds -= deltaTime; }
-                playerSystem.PausedStep(deltaTime);
-            }
-            else
+            const float deltaTime = tickSeconds;
+            tickAccumulator -= tickSeconds;
+            ++ticksThisFrame;
+
+            // What the tick starts from, frames are drawn in between that and what it ends with
+            renderer.SaveTickState();
+
+            if(console_is_hidden())
             {
-                world.UpdateMode();
-                world.step(deltaTime);
-                //printf("world.Step: %f seconds\n", timer::timestamp());
-                if(world.GetCurrentMode() == MODE_INGAME)
-                {   
-                    world.HandleMutations();
-                    playerSystem.PrePhysicsStep(deltaTime);
-                    physics.step(deltaTime);
-                    //printf("physics.Step: %f seconds\n", timer::timestamp());
-                    ai.Step(deltaTime);
-                    //printf("ai.Step: %f seconds\n", timer::timestamp());
-                    playerSystem.Step(deltaTime);
-                    //printf("playerSystem.Step: %f seconds\n", timer::timestamp());
-                    itemHolderSystem.Step(deltaTime);
-                    //printf("itemHolderSystem.Step: %f seconds\n", timer::timestamp());
-                    spriteSystem.Step(deltaTime);
-                    //printf("spriteSystem.Step: %f seconds\n", timer::timestamp());
-                    world.handle_collisions();
-                    //printf("handle_collisions: %f seconds\n", timer::timestamp());
-                } else if (Input::HasKeyBeenPressed(SDL_SCANCODE_Q)) {
-                    world.cleanUp();
-                    renderer.CleanUp();
-
-                    SDL_DestroyWindow(window);
-                    SDL_GL_DeleteContext(openglContext);
-                    SDL_Quit();
-                    return EXIT_SUCCESS;
-                } else if (Input::HasKeyBeenPressed(SDL_SCANCODE_R)) {
-                    world.SwapCurrentDifficulty();
+                if(GlobalPauseForSeconds > 0.f || world.gamePaused)
+                {
+                    if(!world.gamePaused) { GlobalPauseForSeconds -= deltaTime; }
+                    playerSystem.PausedStep(deltaTime);
+                }
+                else
+                {
+                    world.UpdateMode();
+                    world.step(deltaTime);
+                    //printf("world.Step: %f seconds\n", timer::timestamp());
+                    if(world.GetCurrentMode() == MODE_INGAME)
+                    {   
+                        // Listed in the order they used to run in. Systems that don't touch the same components or
+                        // resources run at the same time, the rest keep this order (type "tasks" in the console).
+                        frameTasks.clear();
+                        frameTasks.add("HandleMutations", SystemAccess::Exclusive(),
+                            [&]{ world.HandleMutations(); });
+                        frameTasks.add("PlayerPrePhysics", system_access<Write<Player>, Write<TransformComponent>, Write<CollisionComponent>, Write<SpriteComponent>, Write<MotionComponent>>(RESOURCE_STRUCTURE | RESOURCE_GAME_STATE | RESOURCE_AUDIO),
+                            [&]{ playerSystem.PrePhysicsStep(deltaTime); });
+                        frameTasks.add("Physics", system_access<Write<TransformComponent>, Write<MotionComponent>, Write<CollisionComponent>, Read<Player>, Read<Enemy>, Read<Item>, Read<Exp>, Read<Coin>, Read<HealthPotion>, Read<HealthBar>, Read<FastMover>>(RESOURCE_STRUCTURE | RESOURCE_COMMANDS | RESOURCE_CONTACTS),
+                            [&]{ physics.step(deltaTime); });
+                        frameTasks.add("AI", SystemAccess::Exclusive(),
+                            [&]{ ai.Step(deltaTime); });
+                        frameTasks.add("Player", system_access<Write<Player>, Write<TransformComponent>, Write<MotionComponent>, Write<CollisionComponent>, Write<SpriteComponent>, Write<HolderComponent>, Write<Weapon>>(RESOURCE_STRUCTURE | RESOURCE_GAME_STATE | RESOURCE_AUDIO | RESOURCE_CONTACTS),
+                            [&]{ playerSystem.Step(deltaTime); });
+                        frameTasks.add("ItemHolder", system_access<Write<HolderComponent>, Write<Item>, Write<Weapon>, Write<ActivePlayerProjectile>, Write<PlayerProjectile>, Write<FastMover>, Write<TransformComponent>, Write<MotionComponent>, Write<CollisionComponent>, Write<SpriteComponent>>(RESOURCE_STRUCTURE | RESOURCE_COMMANDS | RESOURCE_GAME_STATE | RESOURCE_AUDIO),
+                            [&]{ itemHolderSystem.Step(deltaTime); });
+                        frameTasks.add("AIPathing", system_access<Write<PathingBehavior>, Write<PatrollingBehavior>, Write<VisionComponent>, Write<MotionComponent>, Read<Enemy>, Read<Player>, Read<TransformComponent>, Read<CollisionComponent>, Read<DeathTimer>, Read<FlyingBehavior>, Write<WalkingBehavior>>(RESOURCE_AI_STATE),
+                            [&]{ ai.PathingStep(deltaTime); });
+                        frameTasks.add("Sprites", system_access<Write<SpriteComponent>>(),
+                            [&]{ spriteSystem.Step(deltaTime); });
+                        frameTasks.add("HandleCollisions", SystemAccess::Exclusive(),
+                            [&]{ world.handle_collisions(); });
+                        frameTasks.run();
+                    } else if (Input::HasKeyBeenPressed(SDL_SCANCODE_Q)) {
+                        world.cleanUp();
+                        renderer.CleanUp();
+
+                        SDL_DestroyWindow(window);
+                        SDL_GL_DeleteContext(openglContext);
+                        SDL_Quit();
+                        job_system_shutdown();
+                        return EXIT_SUCCESS;
+                    } else if (Input::HasKeyBeenPressed(SDL_SCANCODE_R)) {
+                        world.SwapCurrentDifficulty();
+                    }
                 }
-            }
             
-            ui.Step(deltaTime);
-        }
+                ui.Step(deltaTime);
+
+                // Sync point: apply the entity creates / destroys the systems deferred this tick
+                registry.flush_commands();
+            }
 
-        console_update(deltaTime);
+            // Presses and releases belong to the tick that saw them, frames without a tick keep them for the next one
+            Input::ResetControllerStates();
+            Input::ResetKeyboardStates();
+        }
+        if(ticksThisFrame == maxTicksPerFrame)
+        {
+            tickAccumulator = min(tickAccumulator, tickSeconds); // fell behind, drop the backlog
+        }
+        renderer.tickInterpolation = tickAccumulator / tickSeconds;
 
-        Input::ResetControllerStates();
-        Input::ResetKeyboardStates();
+        console_update(frameSeconds);
 
         renderer.Draw(elapsed_ms);
         //printf("Draw: %f seconds\n", timer::timestamp());
@@ -251,6 +317,7 @@ int main(int argc, char* argv[])
     SDL_DestroyWindow(window);
     SDL_GL_DeleteContext(openglContext);
     SDL_Quit();
+    job_system_shutdown();
 
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,660 @@
+#include "pathfinding.hpp"
+#include "job_system.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+std::shared_ptr<NavGrid> NavGrid::FromTileGrid(std::shared_ptr<const TileGrid> tiles)
+{
+    std::shared_ptr<NavGrid> grid = std::make_shared<NavGrid>();
+    grid->width = tiles->width;
+    grid->height = tiles->height;
+    grid->tiles = std::move(tiles);
+    return grid;
+}
+
+// Seconds a jump at 'jumpSpeed' takes until it comes back down 'rise' tiles above the take-off point (rise < 0
+// lands below it), negative if the jump never gets that high
+INTERNAL float JumpAirtime(const WalkerMovement& movement, float rise)
+{
+    const float underRoot = movement.jumpSpeed * movement.jumpSpeed - 2.f * movement.gravity * rise;
+    if (underRoot < 0.f)
+        return -1.f;
+    return (movement.jumpSpeed + std::sqrt(underRoot)) / movement.gravity;
+}
+
+// Nothing solid in the rectangle of tiles between the two corners, inclusive
+INTERNAL bool AreaIsFree(const NavGrid& grid, int x0, int y0, int x1, int y1)
+{
+    for (int y = std::min(y0, y1); y <= std::max(y0, y1); ++y)
+        for (int x = std::min(x0, x1); x <= std::max(x0, x1); ++x)
+            if (!grid.IsFree(x, y))
+                return false;
+    return true;
+}
+
+const u32 PlatformGraph::INVALID;
+
+void PlatformGraph::Build(const NavGrid& grid, const WalkerMovement& movement)
+{
+    const int width = (int)grid.width;
+    const int height = (int)grid.height;
+    spans.clear();
+    links.clear();
+    spanAt.assign(grid.width * grid.height, INVALID);
+    climbsLadders = movement.climbsLadders;
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            if (!grid.IsStandable(x, y))
+                continue;
+            PlatformSpan span;
+            span.row = (i16)y;
+            span.left = (i16)x;
+            while (x + 1 < width && grid.IsStandable(x + 1, y))
+                ++x;
+            span.right = (i16)x;
+            for (int i = span.left; i <= span.right; ++i)
+                spanAt[y * width + i] = (u32)spans.size();
+            spans.push_back(span);
+        }
+
+    const int maxRise = (int)(movement.jumpSpeed * movement.jumpSpeed / (2.f * movement.gravity));
+    // Jumping further down than this is only ever worth it across a gap, and falls cover the rest
+    const int maxDrop = 6;
+
+    for (u32 s = 0; s < (u32)spans.size(); ++s)
+    {
+        PlatformSpan& span = spans[s];
+        span.firstLink = (u32)links.size();
+        const int y = span.row;
+
+        // Walking off either end
+        const int ends[2][2] = { { span.left, -1 }, { span.right, 1 } };
+        for (const auto& end : ends)
+        {
+            const int fallX = end[0] + end[1];
+            if (!grid.IsFree(fallX, y))
+                continue;
+            u32 landing = SpanBelow(grid, fallX, y);
+            if (landing == INVALID || landing == s)
+                continue;
+            PlatformLink link;
+            link.to = landing;
+            link.fromX = (i16)end[0];
+            link.toX = (i16)fallX;
+            link.cost = (u16)(1 + spans[landing].row - y);
+            link.kind = LINK_FALL;
+            links.push_back(link);
+        }
+
+        // Jumps onto every span in reach. Takes off from and lands on the closest tiles of the two spans, never
+        // straight up since the other span's floor would be in the way.
+        for (u32 t = 0; t < (u32)spans.size(); ++t)
+        {
+            const PlatformSpan& target = spans[t];
+            const int rise = y - target.row;
+            if (t == s || rise > maxRise || -rise > maxDrop)
+                continue;
+
+            int fromX, toX;
+            if (target.right < span.left)      { fromX = span.left;  toX = target.right; }
+            else if (target.left > span.right) { fromX = span.right; toX = target.left; }
+            else if (target.left - 1 >= span.left)   { fromX = target.left - 1;  toX = target.left; }
+            else if (target.right + 1 <= span.right) { fromX = target.right + 1; toX = target.right; }
+            else continue;
+
+            const float airtime = JumpAirtime(movement, (float)rise);
+            if (airtime < 0.f || (float)std::abs(toX - fromX) > movement.maxMoveSpeed * airtime)
+                continue;
+            // Room to get off the ground (and up to the other span), a clear row over to it and down onto it
+            const int top = std::min(y - 1, (int)target.row);
+            if (!AreaIsFree(grid, fromX, y, fromX, top) || !AreaIsFree(grid, fromX, top, toX, top) ||
+                !AreaIsFree(grid, toX, top, toX, target.row))
+                continue;
+
+            PlatformLink link;
+            link.to = t;
+            link.fromX = (i16)fromX;
+            link.toX = (i16)toX;
+            link.cost = (u16)(std::abs(toX - fromX) + std::abs(rise) + 1);
+            link.kind = LINK_JUMP;
+            links.push_back(link);
+        }
+
+        span.linkCount = (u32)links.size() - span.firstLink;
+    }
+
+    // Ladders link the span at their foot with the one they lead up to, both ways. Added in a second pass so
+    // every span's links stay contiguous: they go to the end and the spans they start from get them re-sorted.
+    std::vector<PlatformLink> ladderLinks;
+    std::vector<u32> ladderFrom;
+    for (int x = 0; x < width; ++x)
+        for (int y = 0; y < height; ++y)
+        {
+            if (!grid.IsLadder(x, y))
+                continue;
+            const int topY = y;
+            while (grid.IsLadder(x, y + 1))
+                ++y;
+            const u32 bottom = SpanBelow(grid, x, y);
+            u32 top = INVALID;
+            int topX = x;
+            const int exits[3] = { x, x - 1, x + 1 };
+            for (int exitX : exits)
+                if (grid.IsStandable(exitX, topY - 1))
+                {
+                    top = spanAt[(topY - 1) * width + exitX];
+                    topX = exitX;
+                    break;
+                }
+            if (bottom == INVALID || top == INVALID || bottom == top)
+                continue;
+
+            PlatformLink up;
+            up.to = top;
+            up.fromX = (i16)x;
+            up.toX = (i16)topX;
+            up.cost = (u16)(std::abs(spans[bottom].row - spans[top].row) + std::abs(topX - x));
+            up.kind = LINK_LADDER;
+            PlatformLink down = up;
+            down.to = bottom;
+            down.fromX = (i16)topX;
+            down.toX = (i16)x;
+            ladderLinks.push_back(up);
+            ladderFrom.push_back(bottom);
+            ladderLinks.push_back(down);
+            ladderFrom.push_back(top);
+        }
+    if (!ladderLinks.empty())
+    {
+        std::vector<PlatformLink> merged;
+        merged.reserve(links.size() + ladderLinks.size());
+        for (u32 s = 0; s < (u32)spans.size(); ++s)
+        {
+            PlatformSpan& span = spans[s];
+            const u32 first = (u32)merged.size();
+            merged.insert(merged.end(), links.begin() + span.firstLink, links.begin() + span.firstLink + span.linkCount);
+            for (size_t i = 0; i < ladderLinks.size(); ++i)
+                if (ladderFrom[i] == s)
+                    merged.push_back(ladderLinks[i]);
+            span.firstLink = first;
+            span.linkCount = (u32)merged.size() - first;
+        }
+        links.swap(merged);
+    }
+}
+
+u32 PlatformGraph::SpanBelow(const NavGrid& grid, int x, int y) const
+{
+    if (!grid.IsFree(x, y))
+        --y; // hanging into a solid tile a little, stands on top of it
+    for (; grid.IsFree(x, y); ++y)
+        if (spanAt[y * grid.width + x] != INVALID)
+            return spanAt[y * grid.width + x];
+    return INVALID;
+}
+
+// A* over the spans of a PlatformGraph. A span is entered at one tile and left at another, the walk in between
+// is added to the cost of the link it leaves by, so each span remembers the tile of its cheapest entry. Open list
+// is a plain binary heap with stale entries skipped, the graphs are small enough that decrease-key doesn't pay.
+class PlatformAStar
+{
+public:
+    void Search(const NavGrid& grid, const PathRequest& request, PathResult& result)
+    {
+        const PlatformGraph& graph = grid.platforms;
+        const int startX = (int)request.start.x;
+        const int goalX = (int)request.goal.x;
+        const u32 start = graph.SpanBelow(grid, startX, (int)request.start.y);
+        const u32 goal = graph.SpanBelow(grid, goalX, (int)request.goal.y);
+        if (start == PlatformGraph::INVALID || goal == PlatformGraph::INVALID)
+            return;
+        const int goalRow = graph.spans[goal].row;
+
+        const u32 spanCount = (u32)graph.spans.size();
+        cost.assign(spanCount, ~(u32)0);
+        entryX.resize(spanCount);
+        parentLink.resize(spanCount);
+        parentSpan.resize(spanCount);
+        closed.assign(spanCount, 0);
+        while (!open.empty())
+            open.pop();
+
+        cost[start] = 0;
+        entryX[start] = (i16)startX;
+        parentLink[start] = PlatformGraph::INVALID;
+        parentSpan[start] = start;
+        open.push({ Estimate(graph, start, startX, goalX, goalRow), start });
+
+        while (!open.empty())
+        {
+            const u32 current = open.top().span;
+            open.pop();
+            if (closed[current])
+                continue;
+            closed[current] = 1;
+            ++result.nodesExpanded;
+
+            if (current == goal)
+            {
+                FirstStep(graph, start, goal, startX, goalX, result);
+                result.pathLength = cost[goal] + (u32)std::abs(entryX[goal] - goalX);
+                return;
+            }
+
+            const PlatformSpan& span = graph.spans[current];
+            for (u32 l = span.firstLink; l < span.firstLink + span.linkCount; ++l)
+            {
+                const PlatformLink& link = graph.links[l];
+                if (link.kind == LINK_LADDER && !graph.climbsLadders)
+                    continue;
+                if (closed[link.to])
+                    continue;
+                const u32 nextCost = cost[current] + (u32)std::abs(entryX[current] - link.fromX) + link.cost;
+                if (nextCost >= cost[link.to])
+                    continue;
+                cost[link.to] = nextCost;
+                entryX[link.to] = link.toX;
+                parentLink[link.to] = l;
+                parentSpan[link.to] = current;
+                open.push({ nextCost + Estimate(graph, link.to, link.toX, goalX, goalRow), link.to });
+            }
+        }
+    }
+
+private:
+    struct OpenEntry
+    {
+        u32 estimate;
+        u32 span;
+        bool operator>(const OpenEntry& other) const { return estimate > other.estimate; }
+    };
+
+    std::vector<u32> cost;       // cheapest known cost from the start to the entry tile
+    std::vector<i16> entryX;     // tile that cost gets the walker to
+    std::vector<u32> parentLink; // link taken to get there
+    std::vector<u32> parentSpan; // and the span it leaves
+    std::vector<u8> closed;
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+
+    // Manhattan distance from the entry tile to the goal tile, links never cost less than the distance they cover
+    static u32 Estimate(const PlatformGraph& graph, u32 span, int x, int goalX, int goalRow)
+    {
+        return (u32)(std::abs(x - goalX) + std::abs(graph.spans[span].row - goalRow));
+    }
+
+    // What the walker does right now: walk to the goal or the take-off tile of the first link, or take the link
+    // if it is already there
+    void FirstStep(const PlatformGraph& graph, u32 start, u32 goal, int startX, int goalX, PathResult& result) const
+    {
+        result.found = true;
+        if (goal == start)
+        {
+            result.direction = vec2((float)((goalX > startX) - (goalX < startX)), 0.f);
+            return;
+        }
+        u32 span = goal;
+        while (parentSpan[span] != start)
+            span = parentSpan[span];
+        const PlatformLink& first = graph.links[parentLink[span]];
+        if (first.fromX != startX)
+        {
+            result.direction = vec2((float)(first.fromX > startX ? 1 : -1), 0.f);
+            return;
+        }
+        result.direction = vec2((float)((first.toX > first.fromX) - (first.toX < first.fromX)), 0.f);
+        if (first.kind == LINK_JUMP)
+            result.jump = true;
+        else if (first.kind == LINK_LADDER)
+            result.direction.y = graph.spans[first.to].row < graph.spans[start].row ? -1.f : 1.f;
+    }
+
+};
+
+// Manhattan distance heuristic for heuristic search. Every step costs 1 and moves one tile, so it never overestimates.
+INTERNAL u32 Heuristic(i32 x, i32 y, i32 goalX, i32 goalY)
+{
+    return (u32)(std::abs(x - goalX) + std::abs(y - goalY));
+}
+
+// A* over the free tiles of a NavGrid, 4-connected, with an indexed binary heap as the open list, so picking
+// the cheapest node and lowering the cost of one already in it are both O(log n). Costs, parents and heap
+// positions live in flat arrays indexed by tile, sized to the grid once and reused by every search on the
+// thread; a search only clears the two bitsets.
+class GridAStar
+{
+public:
+    // Fills 'result' with the first step of the cheapest path, or leaves found = false if there is none
+    void Search(const NavGrid& grid, const PathRequest& request, PathResult& result)
+    {
+        Prepare(grid);
+
+        const i32 width = (i32)grid.width;
+        const i32 startX = (i32)request.start.x, startY = (i32)request.start.y;
+        const i32 goalX = (i32)request.goal.x, goalY = (i32)request.goal.y;
+        if (!grid.InBounds(startX, startY) || !grid.IsFree(goalX, goalY))
+            return;
+
+        const u32 start = (u32)(startY * width + startX);
+        const u32 goal = (u32)(goalY * width + goalX);
+
+        cost[start] = 0;
+        parent[start] = start;
+        Open(start, Heuristic(startX, startY, goalX, goalY));
+
+        while (heapSize > 0)
+        {
+            const u32 current = PopCheapest();
+            SetBit(closed, current);
+            ++result.nodesExpanded;
+
+            if (current == goal)
+            {
+                // Walk back to the tile right after the start
+                u32 step = current;
+                u32 length = 1;
+                while (parent[step] != start)
+                {
+                    step = parent[step];
+                    ++length;
+                }
+                result.found = true;
+                result.pathLength = length;
+                result.direction = vec2((float)((i32)(step % width) - startX), (float)((i32)(step / width) - startY));
+                return;
+            }
+
+            const i32 x = (i32)(current % width);
+            const i32 y = (i32)(current / width);
+            const i32 neighbours[4][2] = { { x, y - 1 }, { x + 1, y }, { x, y + 1 }, { x - 1, y } };
+
+            const u32 nextCost = cost[current] + 1;
+            for (int n = 0; n < 4; ++n)
+            {
+                const i32 nx = neighbours[n][0], ny = neighbours[n][1];
+                if (!grid.IsFree(nx, ny))
+                    continue;
+                const u32 next = (u32)(ny * width + nx);
+                if (GetBit(closed, next))
+                    continue;
+                if (!GetBit(seen, next))
+                {
+                    cost[next] = nextCost;
+                    parent[next] = current;
+                    Open(next, nextCost + Heuristic(nx, ny, goalX, goalY));
+                }
+                else if (nextCost < cost[next])
+                {
+                    cost[next] = nextCost;
+                    parent[next] = current;
+                    Lower(next, nextCost + Heuristic(nx, ny, goalX, goalY));
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<u32> cost;      // cheapest known cost from the start, valid where 'seen' is set
+    std::vector<u32> parent;    // tile we came from on that path
+    std::vector<u32> estimate;  // cost + heuristic, the heap key
+    std::vector<u32> heapSlot;  // where the tile sits in 'heap' while it is open
+    std::vector<u32> heap;
+    std::vector<u64> seen;      // opened at some point in this search
+    std::vector<u64> closed;    // expanded in this search
+    u32 heapSize = 0;
+
+    void Prepare(const NavGrid& grid)
+    {
+        const u32 tileCount = grid.width * grid.height;
+        if (cost.size() != tileCount)
+        {
+            cost.resize(tileCount);
+            parent.resize(tileCount);
+            estimate.resize(tileCount);
+            heapSlot.resize(tileCount);
+            heap.resize(tileCount);
+            seen.resize((tileCount + 63) / 64);
+            closed.resize((tileCount + 63) / 64);
+        }
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        heapSize = 0;
+    }
+
+    static bool GetBit(const std::vector<u64>& bits, u32 i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+    static void SetBit(std::vector<u64>& bits, u32 i) { bits[i >> 6] |= (u64)1 << (i & 63); }
+
+    // Cheaper estimate first, on a tie the one further along (larger cost) so the search heads for the goal
+    bool Before(u32 a, u32 b) const
+    {
+        return estimate[a] != estimate[b] ? estimate[a] < estimate[b] : cost[a] > cost[b];
+    }
+
+    void Place(u32 slot, u32 tile)
+    {
+        heap[slot] = tile;
+        heapSlot[tile] = slot;
+    }
+
+    void SiftUp(u32 slot)
+    {
+        const u32 tile = heap[slot];
+        while (slot > 0)
+        {
+            const u32 up = (slot - 1) / 2;
+            if (!Before(tile, heap[up]))
+                break;
+            Place(slot, heap[up]);
+            slot = up;
+        }
+        Place(slot, tile);
+    }
+
+    void SiftDown(u32 slot)
+    {
+        const u32 tile = heap[slot];
+        for (;;)
+        {
+            u32 child = slot * 2 + 1;
+            if (child >= heapSize)
+                break;
+            if (child + 1 < heapSize && Before(heap[child + 1], heap[child]))
+                ++child;
+            if (!Before(heap[child], tile))
+                break;
+            Place(slot, heap[child]);
+            slot = child;
+        }
+        Place(slot, tile);
+    }
+
+    void Open(u32 tile, u32 key)
+    {
+        SetBit(seen, tile);
+        estimate[tile] = key;
+        heap[heapSize] = tile;
+        SiftUp(heapSize++);
+    }
+
+    void Lower(u32 tile, u32 key)
+    {
+        estimate[tile] = key;
+        SiftUp(heapSlot[tile]);
+    }
+
+    u32 PopCheapest()
+    {
+        const u32 tile = heap[0];
+        if (--heapSize > 0)
+        {
+            heap[0] = heap[heapSize];
+            SiftDown(0);
+        }
+        return tile;
+    }
+};
+
+PathResult FindPath(const NavGrid& grid, const PathRequest& request)
+{
+    PathResult result;
+    result.entity = request.entity;
+    result.agent = request.agent;
+    result.start = request.start;
+
+    if (request.start == request.goal)
+        return result;
+
+    if (request.agent == PATH_AGENT_WALKING)
+    {
+        LOCAL_PERSIST thread_local PlatformAStar platformSearch;
+        platformSearch.Search(grid, request, result);
+    }
+    else
+    {
+        LOCAL_PERSIST thread_local GridAStar search;
+        search.Search(grid, request, result);
+    }
+    return result;
+}
+
+INTERNAL const int stepOffsets[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } }; // above, right, below, left
+INTERNAL const u8 NO_STEP = 0xff;
+
+void FlowField::Build(const NavGrid& navGrid, int x, int y)
+{
+    grid = &navGrid;
+    goalX = x;
+    goalY = y;
+    const u32 width = navGrid.width;
+    const u32 tileCount = width * navGrid.height;
+    distance.assign(tileCount, (u16)UNREACHABLE);
+    step.assign(tileCount, NO_STEP);
+    frontier.clear();
+    if (!navGrid.IsFree(goalX, goalY))
+        return;
+
+    // The frontier vector is the queue, 'head' walks it
+    const u32 goal = (u32)goalY * width + (u32)goalX;
+    distance[goal] = 0;
+    frontier.push_back(goal);
+    for (size_t head = 0; head < frontier.size(); ++head)
+    {
+        const u32 current = frontier[head];
+        const int cx = (int)(current % width);
+        const int cy = (int)(current / width);
+        for (u8 d = 0; d < 4; ++d)
+        {
+            const int nx = cx + stepOffsets[d][0];
+            const int ny = cy + stepOffsets[d][1];
+            if (!navGrid.IsFree(nx, ny))
+                continue;
+            const u32 next = (u32)ny * width + (u32)nx;
+            if (distance[next] != UNREACHABLE)
+                continue;
+            distance[next] = distance[current] + 1;
+            step[next] = (d + 2) % 4; // back the way we came, toward the goal
+            frontier.push_back(next);
+        }
+    }
+}
+
+bool FlowField::NextStep(int x, int y, vec2& direction) const
+{
+    if (!grid || !grid->InBounds(x, y))
+        return false;
+    u8 d = step[(u32)y * grid->width + (u32)x];
+    if (d == NO_STEP && !grid->IsFree(x, y))
+    {
+        // Agents can hang into a solid tile a little, head for the neighbour closest to the goal like A* would
+        u16 closest = UNREACHABLE;
+        for (u8 n = 0; n < 4; ++n)
+        {
+            u16 neighbourDistance = DistanceAt(x + stepOffsets[n][0], y + stepOffsets[n][1]);
+            if (neighbourDistance < closest)
+            {
+                closest = neighbourDistance;
+                d = n;
+            }
+        }
+    }
+    if (d == NO_STEP)
+        return false;
+    direction = vec2((float)stepOffsets[d][0], (float)stepOffsets[d][1]);
+    return true;
+}
+
+u16 FlowField::DistanceAt(int x, int y) const
+{
+    if (!grid || !grid->InBounds(x, y))
+        return UNREACHABLE;
+    return distance[(u32)y * grid->width + (u32)x];
+}
+
+PathRequestQueue::~PathRequestQueue()
+{
+    job_wait(pending);
+}
+
+void PathRequestQueue::SetGrid(std::shared_ptr<const NavGrid> newGrid)
+{
+    grid = std::move(newGrid);
+}
+
+void PathRequestQueue::Submit(const PathRequest& request)
+{
+    const u32 id = request.entity.GetID();
+    const u32 queued = submittedAt.find(id);
+    if (queued != SparseEntityIndex::INVALID)
+    {
+        submitted[queued] = request;
+        ++requestsReplaced;
+        return;
+    }
+    submittedAt.set(id, (u32)submitted.size());
+    submitted.push_back(request);
+}
+
+void PathRequestQueue::Dispatch()
+{
+    if (submitted.empty() || !grid || resultsReady)
+        return;
+
+    for (const PathRequest& request : submitted)
+        submittedAt.reset(request.entity.GetID());
+    solving.swap(submitted);
+    submitted.clear();
+    results.resize(solving.size());
+    solvingGrid = grid;
+    resultsReady = true;
+
+    const u32 requestsPerJob = 8;
+    for (u32 begin = 0; begin < (u32)solving.size(); begin += requestsPerJob)
+    {
+        u32 end = begin + requestsPerJob < (u32)solving.size() ? begin + requestsPerJob : (u32)solving.size();
+        job_submit([this, begin, end]() {
+            for (u32 i = begin; i < end; ++i)
+                results[i] = FindPath(*solvingGrid, solving[i]);
+        }, pending);
+    }
+}
+
+bool PathRequestQueue::Collect(std::vector<PathResult>& out, bool wait)
+{
+    out.clear();
+    if (!resultsReady)
+        return false;
+    if (wait)
+        job_wait(pending);
+    else if (pending.load(std::memory_order_acquire) > 0)
+        return false;
+    out.swap(results);
+    requestsSolved += (u32)out.size();
+    resultsReady = false;
+    return true;
+}
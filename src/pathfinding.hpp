@@ -0,0 +1,174 @@
+#pragma once
+
+#include "common.hpp"
+#include "tiny_ecs.hpp"
+#include "tile_grid.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+struct NavGrid;
+
+// How far a walking enemy gets on its own, in tiles and seconds (see AISystem::EnemyJumping)
+struct WalkerMovement
+{
+    float jumpSpeed = 0.f;
+    float gravity = 0.f;
+    float maxMoveSpeed = 0.f;
+    bool climbsLadders = false;
+};
+
+enum PlatformLinkKind : u8
+{
+    LINK_FALL,   // walk off the end of a span and drop onto the one below
+    LINK_JUMP,   // jump from one span onto another within reach
+    LINK_LADDER, // climb between the spans at the bottom and the top of a ladder
+};
+
+// A maximal horizontal run of tiles a walker can stand on: free tiles with something solid right below
+struct PlatformSpan
+{
+    i16 row = 0;
+    i16 left = 0;
+    i16 right = 0; // inclusive
+    u32 firstLink = 0;
+    u32 linkCount = 0;
+};
+
+struct PlatformLink
+{
+    u32 to = 0;      // span index
+    i16 fromX = 0;   // tile the walker leaves its span from
+    i16 toX = 0;     // tile it arrives at on the other span
+    u16 cost = 0;    // never less than the tile distance between the two, so A* can use Manhattan distance
+    PlatformLinkKind kind = LINK_FALL;
+};
+
+// The level as a walker moves through it: walking along a span is free of decisions, so the only nodes are the
+// spans and the only edges are the ways between them. Built once per stage from the grid and the walker's jump,
+// a typical stage has a few hundred spans where the grid has a few thousand tiles.
+class PlatformGraph
+{
+public:
+    void Build(const NavGrid& grid, const WalkerMovement& movement);
+
+    // The span the walker in tile (x, y) stands on or will land on if it is in the air, INVALID if it falls out of the level
+    u32 SpanBelow(const NavGrid& grid, int x, int y) const;
+
+    std::vector<PlatformSpan> spans;
+    std::vector<PlatformLink> links; // grouped by span, spans[i].firstLink .. + linkCount
+    std::vector<u32> spanAt;         // per tile, the span it belongs to or INVALID
+    bool climbsLadders = false;
+
+    static const u32 INVALID = 0xffffffff;
+};
+
+// The level's tiles as the path searches see them. Built once per stage over the level's TileGrid and never
+// changed afterwards, searches running on worker threads hold on to the one they started with.
+struct NavGrid
+{
+    u32 width = 0;
+    u32 height = 0;
+    std::shared_ptr<const TileGrid> tiles;
+    PlatformGraph platforms; // for PATH_AGENT_WALKING, built by BuildPlatforms
+
+    static std::shared_ptr<NavGrid> FromTileGrid(std::shared_ptr<const TileGrid> tiles);
+    void BuildPlatforms(const WalkerMovement& movement) { platforms.Build(*this, movement); }
+
+    bool InBounds(int x, int y) const { return tiles->InBounds(x, y); }
+    bool IsFree(int x, int y) const { return tiles->IsFree(x, y); }
+    bool IsLadder(int x, int y) const { return tiles->Has(x, y, TILE_LADDER); }
+    // Free with something solid right below, out of the bottom of the level doesn't count
+    bool IsStandable(int x, int y) const { return IsFree(x, y) && InBounds(x, y + 1) && !IsFree(x, y + 1); }
+};
+
+enum PathAgent
+{
+    PATH_AGENT_FLYING,  // 4-connected through any free tile
+    PATH_AGENT_WALKING, // walks, falls and jumps between the spans of NavGrid::platforms
+};
+
+struct PathRequest
+{
+    Entity entity;
+    PathAgent agent;
+    vec2 start; // tile coordinates
+    vec2 goal;
+};
+
+struct PathResult
+{
+    Entity entity;
+    PathAgent agent;
+    vec2 start;
+    bool found = false;
+    vec2 direction = { 0.f, 0.f }; // first step from start, one of the four unit directions
+    bool jump = false;             // walkers: jump now, while moving along direction.x
+    u32 pathLength = 0;            // steps from start to goal, walkers count the tiles walked, fallen and jumped
+    u32 nodesExpanded = 0;
+};
+
+// Solves one request on the calling thread with A*, always the whole way to the goal (or until everything
+// reachable from the start has been looked at). Flying agents search the tiles, walking ones the platform graph.
+PathResult FindPath(const NavGrid& grid, const PathRequest& request);
+
+// Steps toward one goal tile for every tile at once: a breadth-first search outward from the goal over the free
+// tiles (4-connected, like flying enemies move) records in each tile which neighbour is one step closer. Built
+// once when the goal changes, after that any number of agents look their next step up in O(1), so the cost is
+// one pass over the level instead of one search per agent.
+class FlowField
+{
+public:
+    void Build(const NavGrid& grid, int goalX, int goalY);
+
+    // Direction of the next step from tile (x, y), false if the goal can't be reached from there or (x, y) is the goal
+    bool NextStep(int x, int y, vec2& direction) const;
+    // Steps from (x, y) to the goal, UNREACHABLE if there is no way
+    u16 DistanceAt(int x, int y) const;
+
+    bool IsBuiltFor(const NavGrid* forGrid, int x, int y) const { return grid == forGrid && goalX == x && goalY == y; }
+
+    static const u16 UNREACHABLE = 0xffff;
+
+private:
+    const NavGrid* grid = nullptr;
+    int goalX = -1;
+    int goalY = -1;
+    std::vector<u16> distance;
+    std::vector<u8> step; // index into the four directions, NO_STEP where there is none
+    std::vector<u32> frontier;
+};
+
+// Requests are collected during a tick and handed to the job system as one batch by Dispatch(). The batch is
+// solved on the workers against the grid that was current when it was dispatched, and Collect() hands out its
+// results on the first tick that finds all of it done, without ever waiting for the workers. Requests submitted
+// while a batch is out stay queued for the next one, only the latest per entity: by the time it goes out an
+// older one would be answering a question about where the entity was.
+class PathRequestQueue
+{
+public:
+    ~PathRequestQueue();
+
+    void SetGrid(std::shared_ptr<const NavGrid> grid);
+    // Replaces the entity's request if it already has one queued
+    void Submit(const PathRequest& request);
+    // Hands the queued requests to the workers, unless the last batch hasn't been collected yet
+    void Dispatch();
+    // Moves the results of the last batch into 'out' if it is done, false while it is still being solved (or
+    // there is none). wait: finish it on this thread first, results then always arrive the tick after the request.
+    bool Collect(std::vector<PathResult>& out, bool wait = false);
+
+    u32 requestsSolved = 0;
+    u32 requestsReplaced = 0; // submitted again before the earlier request went out
+
+private:
+    std::shared_ptr<const NavGrid> grid;
+    std::shared_ptr<const NavGrid> solvingGrid;
+    std::vector<PathRequest> submitted;
+    SparseEntityIndex submittedAt; // entity ID -> its request in submitted
+    std::vector<PathRequest> solving;
+    std::vector<PathResult> results;
+    std::atomic<u32> pending{ 0 };
+    bool resultsReady = false;
+};
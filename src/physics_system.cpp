@@ -1,9 +1,12 @@
 // internal
 #include "physics_system.hpp"
+#include "console.hpp"
 #include "world_init.hpp"
 #include "world_system.hpp"
+#include "spatial_hash.hpp"
+#include "tile_grid.hpp"
 
-CollisionInfo CheckCollision(CollisionComponent& collider1, CollisionComponent& collider2)
+CollisionInfo CheckCollision(const CollisionComponent& collider1, const CollisionComponent& collider2)
 {
 	vec2 max1;
     max1.x = collider1.collider_position.x + ((float) collider1.collision_pos.x);
@@ -46,76 +49,195 @@ CollisionInfo CheckCollision(CollisionComponent& collider1, CollisionComponent&
 	return cinfo;
 }
 
+CollisionComponent TileCollider(const CollisionEvent& tileEvent)
+{
+    CollisionComponent collider;
+    collider.collider_position = vec2(tileEvent.tileX * TILE_SIZE, tileEvent.tileY * TILE_SIZE);
+    collider.collision_neg = { 0, 0 };
+    if (tileEvent.other.GetTag() == TAG_SPIKE)
+    {
+        // the spikes' box as it was when spike tiles had their own collider
+        collider.collider_position += vec2(1.f, 8.f);
+        collider.collision_pos = { 6, 8 };
+    }
+    else
+    {
+        collider.collision_pos = { TILE_SIZE, TILE_SIZE };
+    }
+    return collider;
+}
+
+// Broadphase over every collider, rebuilt each step once they have all moved
+INTERNAL SpatialHash colliderHash(32.f);
+
+// The tiles of the stage being played, static level collision is answered from these instead of colliders
+INTERNAL std::shared_ptr<const TileGrid> levelGrid;
+
+// Narrow phase tests and the collisions they found, over the last step
+struct CollisionStats
+{
+    u32 colliders = 0;
+    u32 pairsTested = 0;
+    u32 pairsColliding = 0;
+    u32 tilesTested = 0;
+    u32 tilesColliding = 0;
+    u32 fastMovers = 0;
+    u32 sweptTileHits = 0;
+    u32 sweptPairsTested = 0;
+    u32 sweptPairsColliding = 0;
+};
+INTERNAL CollisionStats collisionStats;
+
+// The fast movers of the last step: where their box was and how far it went, see SweepFastMover
+struct SweptMover
+{
+    Entity e;
+    vec2 start;
+    vec2 displacement;
+};
+INTERNAL std::vector<SweptMover> sweptMovers;
+
+// How far a fast mover is let into the tile it ran into. The discrete checks then find it there and
+// CheckCollisionWithBlockable pushes it back out the way it came, as with any slower body.
+INTERNAL const float maxSweptPenetration = TILE_SIZE / 4.f;
+
+/** A fast mover can get through a tile in one step, where it ends up says nothing about what it went through.
+ *  Its box is swept along the move instead and stops a little way into the first solid tile in the way. */
+INTERNAL vec2 SweepFastMover(Entity e, vec2 position, u32 colliderIndex, vec2 displacement)
+{
+    auto& colliderColumns = registry.colliders.components.columns;
+    const vec2 boxMin = position - colliderColumns.collision_neg[colliderIndex];
+    const vec2 boxMax = position + colliderColumns.collision_pos[colliderIndex];
+    ++collisionStats.fastMovers;
+
+    // Only loose items collide with the level, enemy projectiles fly through it
+    TileSweepHit hit;
+    if (registry.items.has(e) && registry.items.get(e).collidableWithEnvironment
+        && SweepTiles(*levelGrid, boxMin, boxMax, displacement, hit))
+    {
+        ++collisionStats.sweptTileHits;
+        // Up to the face, then into the tile by what was left of the move across it (capped) and
+        // along the face by all of it, like a slower body scraping along the wall
+        const vec2 toImpact = displacement * hit.time;
+        const vec2 remaining = displacement - toImpact;
+        const float across = dot(remaining, hit.normal);
+        displacement = toImpact + (remaining - hit.normal * across) - hit.normal * min(-across, maxSweptPenetration);
+    }
+    sweptMovers.push_back({ e, position, displacement });
+    return displacement;
+}
+
 /** Move all entities that have a motion component */
 INTERNAL void MoveEntities(float deltaTime)
 {
-    auto& motion_registry = registry.motions;
-    for(u32 i = 0; i< motion_registry.size(); i++)
+    // Integrate velocities straight over the motion columns, the transforms only get touched afterwards.
+    // Each slot only reads and writes its own motion and displacement, so the columns are split across the job system.
+    auto& motionColumns = registry.motions.components.columns;
+    const u32 motionCount = (u32)registry.motions.size();
+    vec2* velocities = motionColumns.velocity.data();
+    const vec2* accelerations = motionColumns.acceleration.data();
+    const vec2* drags = motionColumns.drag.data();
+    const vec2* terminalVelocities = motionColumns.terminalVelocity.data();
+
+    LOCAL_PERSIST std::vector<vec2> displacements;
+    displacements.resize(motionCount);
+    vec2* displacementsOut = displacements.data();
+
+    registry.parallel_for_range<Write<MotionComponent>>([=](u32 begin, u32 end)
     {
-        MotionComponent& motion = motion_registry.components[i];
-        vec2 old_velocity = motion.velocity;
-        if(std::abs(motion.velocity.x) > std::abs(motion.terminalVelocity.x))
-        {
-            motion.velocity.x -= (motion.velocity.x/abs(motion.velocity.x)) * max(abs(motion.acceleration.x), 800.f) * deltaTime;
-        }
-        else
-        {
-            motion.velocity.x += motion.acceleration.x * deltaTime;
-        }
-        if(std::abs(motion.velocity.y) > std::abs(motion.terminalVelocity.y))
-        {
-            motion.velocity.y -= (motion.velocity.y/abs(motion.velocity.y)) * max(abs(motion.acceleration.y), 800.f) * deltaTime;
-        }
-        else
+        for(u32 i = begin; i < end; i++)
         {
-            motion.velocity.y += motion.acceleration.y * deltaTime;
-        }
-        if(motion.drag.x != 0.f || motion.drag.y != 0.f)
-        {
-            if(motion.velocity.x > 0.f)
+            vec2& velocity = velocities[i];
+            const vec2 acceleration = accelerations[i];
+            const vec2 drag = drags[i];
+            const vec2 terminalVelocity = terminalVelocities[i];
+
+            vec2 old_velocity = velocity;
+            if(std::abs(velocity.x) > std::abs(terminalVelocity.x))
             {
-                motion.velocity.x -= motion.drag.x * deltaTime;
-                if(motion.velocity.x < 0.f)
-                {
-                    motion.velocity.x = 0.f;
-                }
+                velocity.x -= (velocity.x/abs(velocity.x)) * max(abs(acceleration.x), 800.f) * deltaTime;
             }
             else
             {
-                motion.velocity.x += motion.drag.x * deltaTime;
-                if(motion.velocity.x > 0.f)
-                {
-                    motion.velocity.x = 0.f;
-                }
+                velocity.x += acceleration.x * deltaTime;
             }
-            if(motion.velocity.y > 0.f)
+            if(std::abs(velocity.y) > std::abs(terminalVelocity.y))
             {
-                motion.velocity.y -= motion.drag.y * deltaTime;
-                if(motion.velocity.y < 0.f)
-                {
-                    motion.velocity.y = 0.f;
-                }
+                velocity.y -= (velocity.y/abs(velocity.y)) * max(abs(acceleration.y), 800.f) * deltaTime;
             }
             else
             {
-                motion.velocity.y += motion.drag.y * deltaTime;
-                if(motion.velocity.y > 0.f)
+                velocity.y += acceleration.y * deltaTime;
+            }
+            if(drag.x != 0.f || drag.y != 0.f)
+            {
+                if(velocity.x > 0.f)
                 {
-                    motion.velocity.y = 0.f;
+                    velocity.x -= drag.x * deltaTime;
+                    if(velocity.x < 0.f)
+                    {
+                        velocity.x = 0.f;
+                    }
+                }
+                else
+                {
+                    velocity.x += drag.x * deltaTime;
+                    if(velocity.x > 0.f)
+                    {
+                        velocity.x = 0.f;
+                    }
+                }
+                if(velocity.y > 0.f)
+                {
+                    velocity.y -= drag.y * deltaTime;
+                    if(velocity.y < 0.f)
+                    {
+                        velocity.y = 0.f;
+                    }
+                }
+                else
+                {
+                    velocity.y += drag.y * deltaTime;
+                    if(velocity.y > 0.f)
+                    {
+                        velocity.y = 0.f;
+                    }
                 }
             }
+
+            displacementsOut[i] = ((float)0.5 * (velocity + old_velocity)) * deltaTime;
         }
+    });
 
-        Entity e = motion_registry.entities[i];
-        TransformComponent& entityTransform = registry.transforms.get(e);
-        entityTransform.position += ((float)0.5 * (motion.velocity + old_velocity)) * deltaTime;
-        if(registry.colliders.has(e))
+    // Motions in the movingSprites group line up with their transforms, only the rest need a lookup
+    const u32 groupCount = registry.movingSprites.size();
+    for(u32 i = 0; i < motionCount; i++)
+    {
+        Entity e = registry.motions.entities[i];
+        u32 transformIndex = i < groupCount ? i : registry.transforms.index_of(e);
+        if(transformIndex == SparseEntityIndex::INVALID)
+        {
+            continue;
+        }
+        auto& entityTransform = registry.transforms.components[transformIndex];
+        u32 colliderIndex = registry.colliders.index_of(e);
+        vec2 displacement = displacements[i];
+        if(colliderIndex != SparseEntityIndex::INVALID && registry.fastMovers.has(e))
         {
-            registry.colliders.get(e).collider_position = registry.transforms.get(e).position;
+            displacement = SweepFastMover(e, entityTransform.position, colliderIndex, displacement);
+        }
+        if(displacement.x != 0.f || displacement.y != 0.f)
+        {
+            entityTransform.position += displacement;
+        }
+        // Every step, not only after a move here: anything may have written the transform since
+        if(colliderIndex != SparseEntityIndex::INVALID)
+        {
+            registry.colliders.components[colliderIndex].collider_position = entityTransform.position;
         }
 
-        Entity& entity = motion_registry.entities[i];
-        if (!registry.players.has(entity)) {
+        auto& motion = registry.motions.components[i];
+        if (!registry.players.has(e)) {
             if (motion.velocity.x > 0.f) {
                 motion.facingRight = true;
             }
@@ -127,15 +249,14 @@ INTERNAL void MoveEntities(float deltaTime)
         // KILL MOVING ENTITY IF THEY FALL OUT OF LEVEL
         if(entityTransform.position.y > ((NUMTILESTALL + 6) * TILE_SIZE))
         {
-            auto _e = motion_registry.entities[i];
-            if(registry.players.has(_e))
+            if(registry.players.has(e))
             {
-                auto& playerHp = registry.healthBar.get(_e);
+                auto& playerHp = registry.healthBar.get(e);
                 playerHp.health = -9999.f;
             }
             else
             {
-                registry.remove_all_components_of(_e);
+                registry.destroy_deferred(e);
             }
         }
     }
@@ -154,49 +275,190 @@ bool ColEventWrapperSorter(ColEventWrapper const& lhs, ColEventWrapper const& rh
             < (abs(rhs.event.collision_overlap.y) - abs(rhs.event.collision_overlap.x));
 }
 
-INTERNAL void CheckAllCollisions()
+// What a collision with each kind of tile reports itself as
+struct TileKind
+{
+    u8 flag;
+    u8 tag;
+};
+INTERNAL const TileKind tileKinds[] = {
+    { TILE_SOLID, TAG_PLAYERBLOCKABLE },
+    { TILE_LADDER, TAG_LADDER },
+    { TILE_SPIKE, TAG_SPIKE },
+    { TILE_ENDPOINT, TAG_LEVELENDPOINT },
+};
+
+/** Collide one collider with the level: only the tiles under its box are looked at, straight from the grid */
+INTERNAL void CheckCollisionsWithTiles(Entity entity, const CollisionComponent& collider, std::vector<ColEventWrapper>& colEventSortingVector)
 {
-    // check all necessary entities
-    std::vector<Entity> entitiesToCheck;
-    entitiesToCheck.push_back(registry.players.entities[0]);
+    const TileGrid& grid = *levelGrid;
+    const vec2 a = collider.collider_position - vec2(collider.collision_neg);
+    const vec2 b = collider.collider_position + vec2(collider.collision_pos);
+    const int x0 = grid.TileX(min(a.x, b.x));
+    const int y0 = grid.TileY(min(a.y, b.y));
+    const int x1 = grid.TileX(max(a.x, b.x));
+    const int y1 = grid.TileY(max(a.y, b.y));
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            u8 flags = grid.FlagsAt(x, y);
+            if (grid.OnBorder(x, y))
+            {
+                flags = TILE_SOLID;
+            }
+            else if ((flags & TILE_SOLID)
+                && !grid.IsFree(x - 1, y) && !grid.IsFree(x + 1, y) && !grid.IsFree(x, y - 1) && !grid.IsFree(x, y + 1))
+            {
+                flags &= ~TILE_SOLID; // buried in the wall, nothing gets here without hitting a neighbour first
+            }
 
-    std::vector<Entity> items = registry.items.entities;
-    entitiesToCheck.insert(entitiesToCheck.end(), items.begin(), items.end());
+            for (const TileKind& kind : tileKinds)
+            {
+                if (!(flags & kind.flag))
+                {
+                    continue;
+                }
 
-    std::vector<Entity> enemies = registry.enemy.entities;
-    entitiesToCheck.insert(entitiesToCheck.end(), enemies.begin(), enemies.end());
+                Entity tile;
+                tile.SetTag(kind.tag);
+                CollisionEvent colEventAgainstTile(tile);
+                colEventAgainstTile.isTile = true;
+                colEventAgainstTile.tileX = x;
+                colEventAgainstTile.tileY = y;
 
-    std::vector<Entity> expEntities = registry.exp.entities;
-    entitiesToCheck.insert(entitiesToCheck.end(), expEntities.begin(), expEntities.end());
+                ++collisionStats.tilesTested;
+                CollisionInfo colInfo = CheckCollision(collider, TileCollider(colEventAgainstTile));
+                if (colInfo.collides)
+                {
+                    ++collisionStats.tilesColliding;
+                    colEventAgainstTile.collision_overlap = colInfo.collision_overlap;
+                    colEventSortingVector.push_back({ entity, colEventAgainstTile });
+                }
+            }
+        }
+    }
+}
 
-    std::vector<Entity> coinEntities = registry.coins.entities;
-    entitiesToCheck.insert(entitiesToCheck.end(), coinEntities.begin(), coinEntities.end());
+INTERNAL void BuildColliderHash()
+{
+    auto& colliderColumns = registry.colliders.components.columns;
+    const u32 colliderCount = (u32)registry.colliders.size();
+
+    LOCAL_PERSIST std::vector<vec2> mins;
+    LOCAL_PERSIST std::vector<vec2> maxs;
+    mins.resize(colliderCount);
+    maxs.resize(colliderCount);
+    for (u32 i = 0; i < colliderCount; ++i)
+    {
+        const vec2 position = colliderColumns.collider_position[i];
+        mins[i] = position - vec2(colliderColumns.collision_neg[i]);
+        maxs[i] = position + vec2(colliderColumns.collision_pos[i]);
+    }
+    colliderHash.Build(mins.data(), maxs.data(), colliderCount);
+}
 
+/** A fast mover can go through a body within one step and overlap it at neither end. Sweep it past the bodies
+ *  along its way as well (as if they stood still) and report the ones it met, like a shorter step would have. */
+INTERNAL void CheckSweptCollisions(const std::vector<u8>& checkedColliders, std::vector<ColEventWrapper>& colEventSortingVector)
+{
+    auto& colliderColumns = registry.colliders.components.columns;
+    const vec2* colliderPositions = colliderColumns.collider_position.data();
+    const vec2* collisionPos = colliderColumns.collision_pos.data();
+    const vec2* collisionNeg = colliderColumns.collision_neg.data();
 
-    std::vector<Entity> healthPotionEntities = registry.healthPotion.entities;
-    entitiesToCheck.insert(entitiesToCheck.end(), healthPotionEntities.begin(), healthPotionEntities.end());
+    LOCAL_PERSIST std::vector<u32> candidates;
+    for (const SweptMover& mover : sweptMovers)
+    {
+        const u32 moverIndex = registry.colliders.index_of(mover.e);
+        if (moverIndex == SparseEntityIndex::INVALID)
+        {
+            continue;
+        }
+        const vec2 startMin = mover.start - collisionNeg[moverIndex];
+        const vec2 startMax = mover.start + collisionPos[moverIndex];
+        const vec2 endMin = startMin + mover.displacement;
+        const vec2 endMax = startMax + mover.displacement;
+
+        candidates.clear();
+        colliderHash.Query(vec2(min(startMin.x, endMin.x), min(startMin.y, endMin.y)),
+                           vec2(max(startMax.x, endMax.x), max(startMax.y, endMax.y)),
+                           [](u32 i) { candidates.push_back(i); });
+        std::sort(candidates.begin(), candidates.end());
+
+        for (u32 i : candidates)
+        {
+            if (i == moverIndex || (!checkedColliders[moverIndex] && !checkedColliders[i]))
+            {
+                continue;
+            }
+            Entity other = registry.colliders.entities[i];
+            if (i < moverIndex && registry.fastMovers.has(other))
+            {
+                continue; // two fast movers, the pair was swept from the other one already
+            }
+            const vec2 otherMin = colliderPositions[i] - collisionNeg[i];
+            const vec2 otherMax = colliderPositions[i] + collisionPos[i];
+            if (endMin.x < otherMax.x && endMax.x > otherMin.x && endMin.y < otherMax.y && endMax.y > otherMin.y)
+            {
+                continue; // still overlapping, the discrete checks have this pair
+            }
+
+            ++collisionStats.sweptPairsTested;
+            float time;
+            vec2 normal;
+            if (SweepBox(startMin, startMax, mover.displacement, otherMin, otherMax, time, normal))
+            {
+                ++collisionStats.sweptPairsColliding;
+                // Went all the way through, there is no overlap left to resolve
+                Entity moverEntity = mover.e;
+                CollisionEvent colEventAgainstOther(other);
+                CollisionEvent colEventAgainstMover(moverEntity);
+                colEventSortingVector.push_back({ moverEntity, colEventAgainstOther });
+                colEventSortingVector.push_back({ other, colEventAgainstMover });
+            }
+        }
+    }
+}
 
+INTERNAL void CheckAllCollisions()
+{
     std::vector<ColEventWrapper> colEventSortingVector;
 
-    for(auto entity : entitiesToCheck)
-    {
-        if (registry.colliders.has(entity)) {
-            CollisionComponent entityCollider = registry.colliders.get(entity);
+    BuildColliderHash();
+    collisionStats.colliders = (u32)registry.colliders.size();
+
+    // Which colliders belong to the entities checked below, only pairs with one of those in them are reported
+    LOCAL_PERSIST std::vector<u8> checkedColliders;
+    checkedColliders.assign(registry.colliders.size(), 0);
 
-            for (int i = 0; i < registry.colliders.size(); ++i)
+    LOCAL_PERSIST std::vector<u32> candidates;
+    auto checkEntity = [&colEventSortingVector](Entity entity)
+    {
+        u32 entityIndex = registry.colliders.index_of(entity);
+        if (entityIndex != SparseEntityIndex::INVALID) {
+            checkedColliders[entityIndex] = 1;
+            CollisionComponent entityCollider = registry.colliders.components[entityIndex];
+
+            // Only the colliders sharing a cell with this one can touch it. Visit them in collider order,
+            // like a scan over all of them would, so the events come out in the same order as before.
+            candidates.clear();
+            colliderHash.Query(entityCollider.collider_position - vec2(entityCollider.collision_neg),
+                               entityCollider.collider_position + vec2(entityCollider.collision_pos),
+                               [](u32 i) { candidates.push_back(i); });
+            std::sort(candidates.begin(), candidates.end());
+
+            for (u32 i : candidates)
             {
                 auto e = registry.colliders.entities[i];
-                if (e == entity) { continue; }
+                if (e.IsSameAs(entity)) { continue; }
                 CollisionComponent otherCollider = registry.colliders.components[i];
 
-                if (length(entityCollider.collider_position - otherCollider.collider_position) > 64.f)
-                {
-                    continue; // if distance b/w is big then don't check
-                }
-
+                ++collisionStats.pairsTested;
                 CollisionInfo colInfo = CheckCollision(entityCollider, otherCollider);
                 if (colInfo.collides)
                 {
+                    ++collisionStats.pairsColliding;
                     CollisionEvent colEventAgainstOther(e);
                     CollisionEvent colEventAgainstEntity(entity);
 
@@ -207,15 +469,29 @@ INTERNAL void CheckAllCollisions()
                     colEventSortingVector.push_back({ e, colEventAgainstEntity });
                 }
             }
+
+            CheckCollisionsWithTiles(entity, entityCollider, colEventSortingVector);
         }
-    }
+    };
+
+    // check all necessary entities, straight from their containers
+    checkEntity(registry.players.entities[0]);
+    for (Entity entity : registry.items.entities) { checkEntity(entity); }
+    for (Entity entity : registry.enemy.entities) { checkEntity(entity); }
+    for (Entity entity : registry.exp.entities) { checkEntity(entity); }
+    for (Entity entity : registry.coins.entities) { checkEntity(entity); }
+    for (Entity entity : registry.healthPotion.entities) { checkEntity(entity); }
+
+    CheckSweptCollisions(checkedColliders, colEventSortingVector);
 
     std::sort(colEventSortingVector.begin(), colEventSortingVector.end(), &ColEventWrapperSorter);
 
+    // Grouped by entity afterwards, each entity's contacts keep the order the sort above put them in
     for(const auto& sortedColEvent : colEventSortingVector)
     {
-        registry.collisionEvents.insert(sortedColEvent.e, sortedColEvent.event, false);
+        registry.contactBuffer.add(sortedColEvent.e, sortedColEvent.event);
     }
+    registry.contactBuffer.sort();
 }
 
 INTERNAL void DoDebugging()
@@ -229,7 +505,20 @@ INTERNAL void DoDebugging()
 
 void PhysicsSystem::step(float deltaTime)
 {
+    levelGrid = GetLevelGrid();
+    collisionStats = CollisionStats();
+    sweptMovers.clear();
     MoveEntities(deltaTime);
     CheckAllCollisions();
     DoDebugging();
 }
+
+void PhysicsSystem::PrintStats()
+{
+    console_printf("collisions last step: %u colliders, %u pairs tested, %u colliding (broadphase: %u entries in %u buckets)\n",
+           collisionStats.colliders, collisionStats.pairsTested, collisionStats.pairsColliding,
+           colliderHash.EntryCount(), colliderHash.BucketCount());
+    console_printf("collisions last step: %u level tiles tested, %u colliding\n", collisionStats.tilesTested, collisionStats.tilesColliding);
+    console_printf("collisions last step: %u fast movers swept, %u stopped by a tile, %u went through a body (%u sweeps tested)\n",
+           collisionStats.fastMovers, collisionStats.sweptTileHits, collisionStats.sweptPairsColliding, collisionStats.sweptPairsTested);
+}
@@ -11,13 +11,18 @@ struct CollisionInfo
     bool collides = false;
 };
 
-CollisionInfo CheckCollision(CollisionComponent& collider1, CollisionComponent& collider2);
+CollisionInfo CheckCollision(const CollisionComponent& collider1, const CollisionComponent& collider2);
+
+// Level tiles have no collider, this is the box the tile a collision event was against collides with
+CollisionComponent TileCollider(const CollisionEvent& tileEvent);
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
 {
 public:
 	void step(float deltaTime);
+	// Broadphase and narrow phase counts of the last step, for the "physics_stats" command
+	void PrintStats();
 
 	PhysicsSystem()
 	{
@@ -51,7 +51,7 @@ INTERNAL bool bFaceRight = false; // facing right previously
 INTERNAL float time_in_animation = 0.f;
 INTERNAL int player_animation_state = 6;
 
-INTERNAL void HandleBasicMovementInput(MotionComponent& playerMotion, Player& playerComponent)
+INTERNAL void HandleBasicMovementInput(MotionComponent::Ref& playerMotion, Player& playerComponent)
 {
     const bool bLeftKeyPressed = Input::GameLeftIsPressed();
     const bool bRightKeyPressed = Input::GameRightIsPressed();
@@ -109,7 +109,7 @@ INTERNAL void HandleBasicMovementInput(MotionComponent& playerMotion, Player& pl
     playerMotion.terminalVelocity.y = playerMaxFallSpeed;
 }
 
-INTERNAL void ResolveComplexMovement(float deltaTime, MotionComponent& playerMotion, const Player* playerComponentPtr)
+INTERNAL void ResolveComplexMovement(float deltaTime, Entity playerEntity, MotionComponent::Ref& playerMotion, const Player* playerComponentPtr)
 {
     const bool bLeftKeyPressed = Input::GameLeftIsPressed();
     const bool bRightKeyPressed = Input::GameRightIsPressed();
@@ -121,32 +121,23 @@ INTERNAL void ResolveComplexMovement(float deltaTime, MotionComponent& playerMot
     bool bCollidedDirectlyAbove = false;
     bool bJumpingAndAscending = bJumping && playerMotion.velocity.y < 0.f;
 
-    std::vector<CollisionEvent> playerRelevantCollisions;
     std::vector<CollisionEvent> groundableCollisions;
     std::vector<CollisionEvent> directlyAboveCollisions;
 
+    // Only the player's own contacts, they sit together in the contact buffer
+    const ContactBuffer::Range playerContacts = registry.contacts(playerEntity);
+
     // Check if grounded or colliding above
-    const auto& collisionsRegistry = registry.collisionEvents;
-    for (u32 i = 0; i < collisionsRegistry.components.size(); ++i)
+    for (const CollisionEvent& colEvent : playerContacts)
     {
-        const CollisionEvent colEvent = collisionsRegistry.components[i];
-        Entity entity = collisionsRegistry.entities[i];
         Entity entity_other = colEvent.other;
 
-        if(entity.GetTag() != TAG_PLAYER)
-        {
-            continue;
-        }
-
         if(entity_other.GetTag() == TAG_PLAYERBLOCKABLE)
         {
-            playerRelevantCollisions.push_back(colEvent);
-
-            Player& player = registry.players.get(entity);
-            CollisionComponent& playerCollider = registry.colliders.get(entity);
+            auto& playerCollider = registry.colliders.get(playerEntity);
 
             // Note(Kevin): this second collision check redundant right now but may become needed later - keep for now?
-            CollisionInfo collisionCheck = CheckCollision(playerCollider, registry.colliders.get(entity_other));
+            CollisionInfo collisionCheck = CheckCollision(playerCollider, TileCollider(colEvent));
             if (collisionCheck.collides && abs(collisionCheck.collision_overlap.y) < abs(collisionCheck.collision_overlap.x))
             {
                 if(collisionCheck.collision_overlap.y <= 0.f
@@ -184,9 +175,10 @@ INTERNAL void ResolveComplexMovement(float deltaTime, MotionComponent& playerMot
     {
         for (auto gcol : groundableCollisions)
         {
-            for (auto pcol : playerRelevantCollisions)
+            for (const CollisionEvent& pcol : playerContacts)
             {
-                if (gcol.collision_overlap.x == pcol.collision_overlap.x
+                if (pcol.other.GetTag() == TAG_PLAYERBLOCKABLE
+                    && gcol.collision_overlap.x == pcol.collision_overlap.x
                     && gcol.collision_overlap.y != pcol.collision_overlap.y)
                 {
                     /* Check we aren't in a wall */
@@ -201,9 +193,10 @@ INTERNAL void ResolveComplexMovement(float deltaTime, MotionComponent& playerMot
     {
         for (auto acol : directlyAboveCollisions)
         {
-            for (auto pcol : playerRelevantCollisions)
+            for (const CollisionEvent& pcol : playerContacts)
             {
-                if (acol.collision_overlap.x == pcol.collision_overlap.x
+                if (pcol.other.GetTag() == TAG_PLAYERBLOCKABLE
+                    && acol.collision_overlap.x == pcol.collision_overlap.x
                     && acol.collision_overlap.y != pcol.collision_overlap.y)
                 {
                     /* Check we aren't in a wall */
@@ -276,9 +269,9 @@ INTERNAL void ResolveComplexMovement(float deltaTime, MotionComponent& playerMot
 
 INTERNAL void HandleItemInteractionInput(HolderComponent& playerHolder)
 {   
-    const bool bThrowKeyPressed = Input::GamePickUpHasBeenPressed() && !Input::GameDownIsPressed() && playerHolder.current_item >= 0 && playerHolder.near_weapon == 0;
-    const bool bPickUpKeyPressed = Input::GamePickUpHasBeenPressed() && playerHolder.near_weapon != 0;
-    const bool bDropKeyPressed = Input::GamePickUpHasBeenPressed() && Input::GameDownIsPressed() && playerHolder.current_item >= 0 && playerHolder.near_weapon == 0;
+    const bool bThrowKeyPressed = Input::GamePickUpHasBeenPressed() && !Input::GameDownIsPressed() && playerHolder.current_item >= 0 && !playerHolder.near_weapon.IsAlive();
+    const bool bPickUpKeyPressed = Input::GamePickUpHasBeenPressed() && playerHolder.near_weapon.IsAlive();
+    const bool bDropKeyPressed = Input::GamePickUpHasBeenPressed() && Input::GameDownIsPressed() && playerHolder.current_item >= 0 && !playerHolder.near_weapon.IsAlive();
     const bool bAttackKeyPressed = Input::GameAttackHasBeenPressed() && playerHolder.current_item >= 0;
     const bool bCycleLeftKeyPressed = Input::GameCycleItemLeftBeenPressed() && playerHolder.carried_items.size() > 1;
     const bool bCycleRightKeyPressed = Input::GameCycleItemRightBeenPressed() && playerHolder.carried_items.size() > 1;
@@ -322,7 +315,7 @@ INTERNAL void HandleDamageCooldown(float deltaTime, Player& playerComponent) {
     }
 }
 
-INTERNAL void HandleSpriteSheetFrame(float deltaTime, MotionComponent& playerMotion, SpriteComponent& playerSprite, Player& playerComponent) {
+INTERNAL void HandleSpriteSheetFrame(float deltaTime, MotionComponent::Ref& playerMotion, SpriteComponent& playerSprite, Player& playerComponent) {
 
     /* NOTES:
     Row 1: Death animation
@@ -402,14 +395,14 @@ INTERNAL void HandleSpriteSheetFrame(float deltaTime, MotionComponent& playerMot
 
 void PlayerSystem::PlayerAttackPrePhysicsStep(float deltaTime)
 {
-    TransformComponent& playerTransform = registry.transforms.get(playerEntity);
+    auto& playerTransform = registry.transforms.get(playerEntity);
 
     if(playerMeleeAttackCooldownTimer > 0.f)
     {
         playerMeleeAttackCooldownTimer -= deltaTime;
     }
 
-    if(playerMeleeAttackEntity != 0)
+    if(playerMeleeAttackEntity.IsAlive())
     {
         playerMeleeAttackLengthTimer -= deltaTime;
         auto& transform = registry.transforms.get(playerMeleeAttackEntity);
@@ -559,9 +552,9 @@ void PlayerSystem::Step(float deltaTime)
     if(registry.players.entities.empty()) { return; }
 
     Player& playerComponent = registry.players.get(playerEntity);
-    MotionComponent& playerMotion = registry.motions.get(playerEntity);
+    auto& playerMotion = registry.motions.get(playerEntity);
     SpriteComponent& playerSprite = registry.sprites.get(playerEntity);
-    TransformComponent& playerTransform = registry.transforms.get(playerEntity);
+    auto& playerTransform = registry.transforms.get(playerEntity);
     HolderComponent& playerHolder = registry.holders.get(playerEntity);
 
     CheckIfLevelUp();
@@ -570,7 +563,7 @@ void PlayerSystem::Step(float deltaTime)
 
     HandleBasicMovementInput(playerMotion, *playerComponentPtr);
     HandleItemInteractionInput(playerHolder);
-    ResolveComplexMovement(deltaTime, playerMotion, playerComponentPtr);
+    ResolveComplexMovement(deltaTime, playerEntity, playerMotion, playerComponentPtr);
     HandleDamageCooldown(deltaTime, playerComponent);
     HandleSpriteSheetFrame(deltaTime, playerMotion, playerSprite, playerComponent);
 }
\ No newline at end of file
@@ -59,14 +59,14 @@ void RenderSystem::DrawBackground(TEXTURE_ASSET_ID texId, float offset)
     GAMELEVELENUM stage = world->GetCurrentStage();
     if (registry.players.size() > 0 && ((stage == CHAPTER_ONE_STAGE_ONE) || (stage == CHAPTER_TWO_STAGE_ONE)) && !world->gamePaused) {
         Entity player = registry.players.entities[0];
-        TransformComponent& playerTransform = registry.transforms.get(player);
-        float playerPositionX = clamp(playerTransform.position.x, cameraBoundMin.x, cameraBoundMax.x);
-        float playerPositionY = clamp(playerTransform.position.y, cameraBoundMin.y, cameraBoundMax.y);
+        vec2 playerDrawPosition = InterpolatedPosition(player);
+        float playerPositionX = clamp(playerDrawPosition.x, cameraBoundMin.x, cameraBoundMax.x);
+        float playerPositionY = clamp(playerDrawPosition.y, cameraBoundMin.y, cameraBoundMax.y);
         cameraPosition = vec2(playerPositionX, playerPositionY);
 
         lightSize = registry.lightSources.size();
         for (int i = 0; i < registry.lightSources.size(); i++) {
-            vec2 pos = registry.transforms.get(registry.lightSources.entities[i]).position;
+            vec2 pos = InterpolatedPosition(registry.lightSources.entities[i]);
             lightArray[(i * 2)] = pos.x;
             lightArray[(i * 2) + 1] = pos.y;
         }
@@ -154,8 +154,7 @@ void RenderSystem::DrawAllBackgrounds(float elapsed_ms)
     {
         if (registry.players.size() > 0 && bgTexId.size() > 1) {
             Entity player = registry.players.entities[0];
-            TransformComponent& playerTransform = registry.transforms.get(player);
-            float playerPositionX = clamp(playerTransform.position.x, cameraBoundMin.x, cameraBoundMax.x);
+            float playerPositionX = clamp(InterpolatedPosition(player).x, cameraBoundMin.x, cameraBoundMax.x);
 
             playerPositionX = playerPositionX - (GAME_RESOLUTION_WIDTH / 2.0f);
             playerPositionX = playerPositionX / GAME_RESOLUTION_WIDTH;
@@ -203,9 +202,9 @@ void RenderSystem::BatchDrawAllSprites(std::vector<SpriteTransformPair>& sortedS
     // CAMERA TRANSFORM
     cameraTransform = Transform();
     Entity player = registry.players.entities[0];
-    TransformComponent& playerTransform = registry.transforms.get(player);
-    float playerPositionX = clamp(playerTransform.position.x, cameraBoundMin.x, cameraBoundMax.x);
-    float playerPositionY = clamp(playerTransform.position.y, cameraBoundMin.y, cameraBoundMax.y);
+    vec2 playerDrawPosition = InterpolatedPosition(player);
+    float playerPositionX = clamp(playerDrawPosition.x, cameraBoundMin.x, cameraBoundMax.x);
+    float playerPositionY = clamp(playerDrawPosition.y, cameraBoundMin.y, cameraBoundMax.y);
     vec2 cameraPosition = vec2(playerPositionX, playerPositionY);
     playerPositionX = playerPositionX - (GAME_RESOLUTION_WIDTH / 2.0f);
     playerPositionY = playerPositionY - (GAME_RESOLUTION_HEIGHT / 2.0f);
@@ -218,7 +217,7 @@ void RenderSystem::BatchDrawAllSprites(std::vector<SpriteTransformPair>& sortedS
     if ((world->GetCurrentStage() == CHAPTER_ONE_STAGE_ONE) || (world->GetCurrentStage() == CHAPTER_TWO_STAGE_ONE)) {
         lightSize = registry.lightSources.size();
         for (int i = 0; i < registry.lightSources.size(); i++) {
-            vec2 pos = registry.transforms.get(registry.lightSources.entities[i]).position;
+            vec2 pos = InterpolatedPosition(registry.lightSources.entities[i]);
             lightArray[(i * 2)] = pos.x;
             lightArray[(i * 2) + 1] = pos.y;
         }
@@ -395,6 +394,42 @@ void RenderSystem::BatchDrawAllSprites(std::vector<SpriteTransformPair>& sortedS
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
+void RenderSystem::SaveTickState()
+{
+    // World texts are pushed by the tick, frames without one keep drawing the last tick's
+    worldTextsThisFrame.clear();
+    // Only the movingSprites group, packed at the front of the transforms, moves from tick to tick. The rest
+    // (tiles, torches, pickups...) are drawn where they are.
+    const u32 groupCount = registry.movingSprites.size();
+    const std::vector<Entity>& entities = registry.transforms.entities;
+    const std::vector<vec2>& positions = registry.transforms.components.columns.position;
+    lastTickEntities.assign(entities.begin(), entities.begin() + groupCount);
+    lastTickPositions.assign(positions.begin(), positions.begin() + groupCount);
+}
+
+vec2 RenderSystem::InterpolatedPosition(u32 transformIndex)
+{
+    const vec2 position = registry.transforms.components.columns.position[transformIndex];
+    // Transforms outside the group, or that joined it or changed slot during the last tick, are drawn where they are
+    if(transformIndex < lastTickEntities.size() && lastTickEntities[transformIndex].IsSameAs(registry.transforms.entities[transformIndex]))
+    {
+        const vec2 lastPosition = lastTickPositions[transformIndex];
+        return lastPosition + (position - lastPosition) * tickInterpolation;
+    }
+    return position;
+}
+
+vec2 RenderSystem::InterpolatedPosition(Entity e)
+{
+    u32 transformIndex = registry.transforms.index_of(e);
+    assert(transformIndex != SparseEntityIndex::INVALID && "Entity has no transform to draw");
+    if(transformIndex == SparseEntityIndex::INVALID)
+    {
+        return vec2(0.f);
+    }
+    return InterpolatedPosition(transformIndex);
+}
+
 void RenderSystem::Draw(float elapsed_ms)
 {
     // First render to the custom framebuffer
@@ -422,14 +457,30 @@ void RenderSystem::Draw(float elapsed_ms)
     if(registry.sprites.size() > 0)
     {
         // SORTING FOR BATCH DRAWING
-        std::vector<SpriteTransformPair> sortedSpriteArray(registry.sprites.size());
-        for(size_t i = 0; i < registry.sprites.size(); ++i)
+        std::vector<SpriteTransformPair> sortedSpriteArray;
+        sortedSpriteArray.reserve(registry.sprites.size());
+        // Render keys only change with the sprite, rebuild the ones that did since the last frame
+        spriteRenderKeys.resize(registry.sprites.size());
+        registry.sprites.each_changed_since(spriteRenderKeysTick, [&](u32 i)
         {
-            SpriteTransformPair s;
-            s.spritePtr = &registry.sprites.components[i];
-            s.renderState = GetRenderState(registry.sprites.components[i]);
-            s.transform = registry.transforms.get(registry.sprites.entities[i]);
-            sortedSpriteArray[i] = s;
+            spriteRenderKeys[i] = GetRenderState(registry.sprites.components[i]);
+        });
+        spriteRenderKeysTick = ChangeTick::Advance();
+
+        // Sprites in the movingSprites group line up with their transforms, the rest (tiles, pickups...) need a lookup
+        const u32 groupCount = registry.movingSprites.size();
+        for(u32 i = 0; i < (u32)registry.sprites.size(); ++i)
+        {
+            u32 transformIndex = i < groupCount ? i : registry.transforms.index_of(registry.sprites.entities[i]);
+            if(transformIndex != SparseEntityIndex::INVALID)
+            {
+                SpriteTransformPair s;
+                s.spritePtr = &registry.sprites.components[i];
+                s.renderState = spriteRenderKeys[i];
+                s.transform = registry.transforms.components[transformIndex];
+                s.transform.position = InterpolatedPosition(transformIndex);
+                sortedSpriteArray.push_back(s);
+            }
         }
 
         // SORT
@@ -484,7 +535,6 @@ void RenderSystem::DrawWorldText(const mat3& projection)
                 glDrawElements(GL_TRIANGLES, worldTextVAO.indicesCount, GL_UNSIGNED_INT, nullptr);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
-    worldTextsThisFrame.clear();
 }
 
 void RenderSystem::DrawUI()
@@ -72,6 +72,12 @@ public:
 	// Draw all entities
 	void Draw(float elapsed_ms);
 
+    // The simulation runs in fixed ticks and frames are drawn in between the last two: call this before every
+    // tick, then set tickInterpolation to how far the frame is past the last tick (0 draws the state the last
+    // tick started from, 1 the one it ended with)
+    void SaveTickState();
+    float tickInterpolation = 1.f;
+
     // Call this when the display resolution (i.e. the window size) changes
     void UpdateBackBufferSize();
 
@@ -164,6 +170,18 @@ private:
 
     Transform cameraTransform;
 
+    // Positions of the movingSprites group before the last tick, by index into registry.transforms
+    std::vector<Entity> lastTickEntities;
+    std::vector<vec2> lastTickPositions;
+
+    // Where a transform is drawn this frame, in between its last two ticks
+    vec2 InterpolatedPosition(u32 transformIndex);
+    vec2 InterpolatedPosition(Entity e);
+
+    // GetRenderState of every sprite, by index into registry.sprites. Only the changed ones are rebuilt each frame.
+    std::vector<u32> spriteRenderKeys;
+    u32 spriteRenderKeysTick = 0;
+
 	// Screen texture handles
 	GLuint gameFrameBuffer;
 	GLuint offScreenRenderBufferColor;
@@ -0,0 +1,50 @@
+#include "spatial_hash.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+
+void SpatialHash::CellRange(vec2 min, vec2 max, int& x0, int& y0, int& x1, int& y1) const
+{
+    // Boxes with a negative size still count as the area between their corners
+    x0 = (int)std::floor(std::min(min.x, max.x) / cellSize);
+    y0 = (int)std::floor(std::min(min.y, max.y) / cellSize);
+    x1 = (int)std::floor(std::max(min.x, max.x) / cellSize);
+    y1 = (int)std::floor(std::max(min.y, max.y) / cellSize);
+}
+
+void SpatialHash::Build(const vec2* mins, const vec2* maxs, u32 count)
+{
+    // About two buckets per box, a power of two so the hash is masked instead of divided
+    u32 bucketCount = 64;
+    while (bucketCount < count * 2)
+        bucketCount *= 2;
+    bucketMask = bucketCount - 1;
+    bucketStart.assign(bucketCount + 1, 0);
+    lastQueried.assign(count, 0);
+    queryStamp = 0;
+
+    // Count the cells of every bucket, turn the counts into start offsets, then file the boxes
+    for (u32 i = 0; i < count; ++i)
+    {
+        int x0, y0, x1, y1;
+        CellRange(mins[i], maxs[i], x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                ++bucketStart[Bucket(x, y) + 1];
+    }
+    for (u32 b = 0; b < bucketCount; ++b)
+        bucketStart[b + 1] += bucketStart[b];
+    entries.resize(bucketStart[bucketCount]);
+
+    LOCAL_PERSIST std::vector<u32> fill;
+    fill.assign(bucketStart.begin(), bucketStart.end() - 1);
+    for (u32 i = 0; i < count; ++i)
+    {
+        int x0, y0, x1, y1;
+        CellRange(mins[i], maxs[i], x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                entries[fill[Bucket(x, y)]++] = i;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// Broadphase for boxes: a uniform grid of square cells over the whole plane, hashed into a fixed number of
+// buckets so the world needs no bounds. Build() files every box under each cell it overlaps, rebuilt from
+// scratch whenever the boxes move; it is a counting sort into one flat array, so there are no per-cell
+// allocations and a query walks contiguous memory. Query() finds every box that shares a cell with the
+// one asked about: a superset of the boxes that overlap it, the caller still does the exact test.
+class SpatialHash
+{
+public:
+    explicit SpatialHash(float cellSize = 32.f) : cellSize(cellSize) {}
+
+    // Boxes are [mins[i], maxs[i]], identified by i in queries
+    void Build(const vec2* mins, const vec2* maxs, u32 count);
+
+    // Calls func(i) once for every box i that shares a cell with [min, max]
+    template <typename Func>
+    void Query(vec2 min, vec2 max, Func func)
+    {
+        if (bucketStart.empty())
+            return;
+        // Boxes can sit in several of the cells (and buckets) we look at, the stamp reports each once
+        if (++queryStamp == 0)
+        {
+            std::fill(lastQueried.begin(), lastQueried.end(), 0);
+            queryStamp = 1;
+        }
+        int x0, y0, x1, y1;
+        CellRange(min, max, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+            {
+                const u32 bucket = Bucket(x, y);
+                for (u32 e = bucketStart[bucket]; e < bucketStart[bucket + 1]; ++e)
+                {
+                    const u32 box = entries[e];
+                    if (lastQueried[box] == queryStamp)
+                        continue;
+                    lastQueried[box] = queryStamp;
+                    func(box);
+                }
+            }
+    }
+
+    u32 BucketCount() const { return bucketStart.empty() ? 0 : (u32)bucketStart.size() - 1; }
+    u32 EntryCount() const { return (u32)entries.size(); }
+
+private:
+    float cellSize;
+    std::vector<u32> bucketStart; // entries of bucket b are entries[bucketStart[b] .. bucketStart[b + 1])
+    std::vector<u32> entries;     // box indices
+    std::vector<u32> lastQueried; // per box, queryStamp of the last query that reported it
+    u32 queryStamp = 0;
+    u32 bucketMask = 0;
+
+    void CellRange(vec2 min, vec2 max, int& x0, int& y0, int& x1, int& y1) const;
+    u32 Bucket(int x, int y) const
+    {
+        return ((u32)x * 73856093u ^ (u32)y * 19349663u) & bucketMask;
+    }
+};
@@ -7,13 +7,11 @@ SpriteSystem::SpriteSystem()
 
 void SpriteSystem::Step(float deltaTime) {
 
-    auto& sprite_registry = registry.sprites;
-    for (u32 i = 0; i < sprite_registry.size(); i++)
+    // Every sprite animates on its own, so the sprites are split across the job system
+    registry.parallel_for_each<Write<SpriteComponent>>([deltaTime](Entity e, SpriteComponent& sprite)
     {
-        SpriteComponent& sprite = sprite_registry.components[i];
-
         if (sprite.animations.empty()) {
-            continue;
+            return;
         }
 
         Animation& current_anim = sprite.animations[sprite.selected_animation];
@@ -34,5 +32,5 @@ void SpriteSystem::Step(float deltaTime) {
                 current_anim.played = true;
             }
         }
-    }
+    });
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "task_graph.hpp"
+#include "job_system.hpp"
+#include "console.hpp"
+
+// stlib
+#include <string>
+
+using TaskClock = std::chrono::high_resolution_clock;
+
+bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+{
+    if ((writes & other.reads) || (reads & other.writes))
+        return true;
+    if (resources & other.resources)
+        return true;
+    // Structural changes move components of any type around
+    if ((resources & RESOURCE_STRUCTURE) && other.reads)
+        return true;
+    if ((other.resources & RESOURCE_STRUCTURE) && reads)
+        return true;
+    return false;
+}
+
+float TaskGraph::MicrosecondsSinceStart() const
+{
+    return (float)std::chrono::duration_cast<std::chrono::nanoseconds>(TaskClock::now() - frameStart).count() / 1000.f;
+}
+
+void TaskGraph::clear()
+{
+    tasks.clear();
+}
+
+void TaskGraph::add(const char* name, SystemAccess access, std::function<void()> run)
+{
+    Task task;
+    task.name = name;
+    task.access = access;
+    task.run = std::move(run);
+    tasks.push_back(std::move(task));
+}
+
+// Runs a task, then whatever it unblocked: one successor on this thread, several as a parallel_for over them,
+// so independent branches of the graph fan out across the job system while this thread helps
+void TaskGraph::RunTask(u32 index)
+{
+    std::vector<u32> unblocked;
+    for (;;)
+    {
+        Task& task = tasks[index];
+        task.thread = job_system_thread_index();
+        task.startUs = MicrosecondsSinceStart();
+        task.run();
+        task.endUs = MicrosecondsSinceStart();
+
+        unblocked.clear();
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            for (u32 successor : task.successors)
+                if (--tasks[successor].pending == 0)
+                    unblocked.push_back(successor);
+        }
+        if (unblocked.size() != 1)
+            break;
+        index = unblocked[0];
+    }
+    RunTasks(unblocked);
+}
+
+void TaskGraph::RunTasks(const std::vector<u32>& indices)
+{
+    parallel_for((u32)indices.size(), 1, [this, &indices](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i)
+            RunTask(indices[i]);
+    });
+}
+
+void TaskGraph::run()
+{
+    const u32 count = (u32)tasks.size();
+    for (u32 j = 0; j < count; ++j)
+    {
+        Task& task = tasks[j];
+        task.successors.clear();
+        task.predecessors.clear();
+        for (u32 i = 0; i < j; ++i)
+            if (tasks[i].access.ConflictsWith(task.access))
+            {
+                tasks[i].successors.push_back(j);
+                task.predecessors.push_back(i);
+            }
+        task.pending = (u32)task.predecessors.size();
+    }
+
+    std::vector<u32> roots;
+    for (u32 i = 0; i < count; ++i)
+        if (tasks[i].pending == 0)
+            roots.push_back(i);
+
+    frameStart = TaskClock::now();
+    RunTasks(roots);
+    frameUs = MicrosecondsSinceStart();
+    FindCriticalPath();
+}
+
+// Tasks only depend on earlier ones, so one pass in order finds the longest chain ending at each task
+void TaskGraph::FindCriticalPath()
+{
+    const u32 count = (u32)tasks.size();
+    LOCAL_PERSIST std::vector<float> chainUs;
+    LOCAL_PERSIST std::vector<int> chainParent;
+    chainUs.assign(count, 0.f);
+    chainParent.assign(count, -1);
+    criticalPath.clear();
+    criticalPathUs = 0.f;
+    if (count == 0)
+        return;
+
+    u32 last = 0;
+    for (u32 j = 0; j < count; ++j)
+    {
+        const Task& task = tasks[j];
+        float longestBefore = 0.f;
+        for (u32 i : task.predecessors)
+            if (chainUs[i] > longestBefore)
+            {
+                longestBefore = chainUs[i];
+                chainParent[j] = (int)i;
+            }
+        chainUs[j] = longestBefore + (task.endUs - task.startUs);
+        if (chainUs[j] > chainUs[last])
+            last = j;
+    }
+
+    for (int i = (int)last; i >= 0; i = chainParent[i])
+        criticalPath.insert(criticalPath.begin(), (u32)i);
+    criticalPathUs = chainUs[last];
+}
+
+void TaskGraph::report()
+{
+    if (tasks.empty())
+    {
+        console_printf("no tasks ran last frame\n");
+        return;
+    }
+
+    float busyUs = 0.f;
+    for (const Task& task : tasks)
+        busyUs += task.endUs - task.startUs;
+    console_printf("%u tasks on %u threads, frame %.1f us, work %.1f us\n", (u32)tasks.size(), job_system_worker_count() + 1, frameUs, busyUs);
+    for (const Task& task : tasks)
+    {
+        std::string after;
+        for (u32 i : task.predecessors)
+        {
+            after += after.empty() ? " after " : ", ";
+            after += tasks[i].name;
+        }
+        console_printf("  %-20s thread %u  %8.1f .. %8.1f us%s\n", task.name, task.thread, task.startUs, task.endUs, after.c_str());
+    }
+
+    std::string path;
+    for (u32 i : criticalPath)
+    {
+        path += path.empty() ? "" : " -> ";
+        path += tasks[i].name;
+    }
+    console_printf("critical path %.1f us: %s\n", criticalPathUs, path.c_str());
+}
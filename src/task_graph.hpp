@@ -0,0 +1,107 @@
+#pragma once
+
+#include "common.hpp"
+#include "tiny_ecs_registry.hpp"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+
+    PER-FRAME SYSTEM TASK GRAPH
+
+    Systems are added in the order they would run one after the other, each with a declaration of what it
+    touches. Two systems conflict if one writes a component type the other reads or writes, or if they share
+    a resource. A system depends on every earlier system it conflicts with; the ones that don't conflict
+    run at the same time on the job system. The order between conflicting systems stays the order they were
+    added in, so the result is the same as running them serially.
+
+*/
+
+// Shared state that isn't a component type. Naming a resource means reading and writing it.
+enum SystemResource : u32
+{
+    RESOURCE_STRUCTURE  = 1 << 0, // inserting / removing components, creating / destroying entities right away. Conflicts with any component access.
+    RESOURCE_COMMANDS   = 1 << 1, // registry.create_deferred / destroy_deferred
+    RESOURCE_GAME_STATE = 1 << 2, // WorldSystem / PlayerSystem / UISystem members, pause timers, level data
+    RESOURCE_AUDIO      = 1 << 3,
+    RESOURCE_AI_STATE   = 1 << 4, // AISystem globals: the think schedule, path requests and its copy of the level tiles
+    RESOURCE_CONTACTS   = 1 << 5, // registry.contactBuffer, filled by the physics step
+    RESOURCE_ALL        = 0xffffffff
+};
+
+struct SystemAccess
+{
+    u64 reads = 0;  // component signature bits read or written
+    u64 writes = 0; // component signature bits written
+    u32 resources = 0;
+
+    // Conflicts with everything, for systems that touch too much to list
+    static SystemAccess Exclusive()
+    {
+        SystemAccess access;
+        access.reads = ~(u64)0;
+        access.writes = ~(u64)0;
+        access.resources = RESOURCE_ALL;
+        return access;
+    }
+
+    bool ConflictsWith(const SystemAccess& other) const;
+};
+
+// The access of a system that touches the Read<> / Write<> component types 'Access' and the SystemResource bits 'resources'
+template <typename... Access>
+SystemAccess system_access(u32 resources = 0)
+{
+    SystemAccess access;
+    access.reads = ECSRegistry::signature_of<typename Access::Component...>();
+    access.writes = ECSRegistry::write_signature_of<Access...>();
+    access.resources = resources;
+    return access;
+}
+
+class TaskGraph
+{
+public:
+    void clear();
+    void add(const char* name, SystemAccess access, std::function<void()> run);
+
+    // Builds the dependencies from the declarations, runs every task and records how long each took
+    void run();
+
+    // The chain of dependent tasks that took the longest in the last run. More threads can't make the frame
+    // faster than this, only shortening these tasks (or splitting their declarations) can.
+    const std::vector<u32>& critical_path() const { return criticalPath; }
+    float critical_path_us() const { return criticalPathUs; }
+
+    // Prints the tasks of the last run with their timings and dependencies, and the critical path
+    void report();
+
+private:
+    struct Task
+    {
+        const char* name;
+        SystemAccess access;
+        std::function<void()> run;
+        std::vector<u32> successors;
+        std::vector<u32> predecessors;
+        u32 pending = 0;
+        float startUs = 0.f;
+        float endUs = 0.f;
+        u32 thread = 0;
+    };
+
+    std::vector<Task> tasks;
+    std::mutex pendingMutex;
+    std::chrono::high_resolution_clock::time_point frameStart;
+    float frameUs = 0.f;
+    std::vector<u32> criticalPath;
+    float criticalPathUs = 0.f;
+
+    void RunTask(u32 index);
+    void RunTasks(const std::vector<u32>& indices);
+    void FindCriticalPath();
+    float MicrosecondsSinceStart() const;
+};
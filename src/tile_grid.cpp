@@ -0,0 +1,150 @@
+#include "tile_grid.hpp"
+
+// stlib
+#include <algorithm>
+
+bool RaycastTiles(const TileGrid& grid, vec2 origin, vec2 direction, float maxDistance, TileRayHit& hit, u8 blockingFlags)
+{
+    const float directionLength = length(direction);
+    if (directionLength <= 0.f)
+        return false;
+    const vec2 dir = direction / directionLength;
+
+    int x = grid.TileX(origin.x);
+    int y = grid.TileY(origin.y);
+    if (grid.Has(x, y, blockingFlags))
+    {
+        hit = TileRayHit();
+        hit.tileX = x;
+        hit.tileY = y;
+        hit.point = origin;
+        return true;
+    }
+
+    // Distance along the ray to the next vertical / horizontal tile boundary, and between two of them
+    const float tileSize = grid.tileSize;
+    const int stepX = dir.x > 0.f ? 1 : (dir.x < 0.f ? -1 : 0);
+    const int stepY = dir.y > 0.f ? 1 : (dir.y < 0.f ? -1 : 0);
+    const float deltaX = stepX != 0 ? tileSize / std::abs(dir.x) : INFINITY;
+    const float deltaY = stepY != 0 ? tileSize / std::abs(dir.y) : INFINITY;
+    float nextX = stepX > 0 ? ((float)(x + 1) * tileSize - origin.x) / dir.x
+                : stepX < 0 ? ((float)x * tileSize - origin.x) / dir.x : INFINITY;
+    float nextY = stepY > 0 ? ((float)(y + 1) * tileSize - origin.y) / dir.y
+                : stepY < 0 ? ((float)y * tileSize - origin.y) / dir.y : INFINITY;
+
+    for (;;)
+    {
+        float distance;
+        vec2 normal;
+        if (nextX < nextY)
+        {
+            x += stepX;
+            distance = nextX;
+            nextX += deltaX;
+            normal = vec2((float)-stepX, 0.f);
+        }
+        else
+        {
+            y += stepY;
+            distance = nextY;
+            nextY += deltaY;
+            normal = vec2(0.f, (float)-stepY);
+        }
+        if (distance > maxDistance)
+            return false;
+        // Left the grid for good
+        if ((x < 0 && stepX <= 0) || (x >= (int)grid.width && stepX >= 0) ||
+            (y < 0 && stepY <= 0) || (y >= (int)grid.height && stepY >= 0))
+            return false;
+        if (grid.Has(x, y, blockingFlags))
+        {
+            hit.tileX = x;
+            hit.tileY = y;
+            hit.distance = distance;
+            hit.point = origin + dir * distance;
+            hit.normal = normal;
+            return true;
+        }
+    }
+}
+
+bool HasLineOfSight(const TileGrid& grid, vec2 from, vec2 to, u8 blockingFlags)
+{
+    TileRayHit hit;
+    return !RaycastTiles(grid, from, to - from, length(to - from), hit, blockingFlags);
+}
+
+bool SweepBox(vec2 boxMin, vec2 boxMax, vec2 displacement, vec2 otherMin, vec2 otherMax, float& time, vec2& normal)
+{
+    // Per axis, the part of the move during which the boxes overlap on that axis. They touch where both do.
+    float enter[2];
+    float exit[2];
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const float d = displacement[axis];
+        if (d == 0.f)
+        {
+            if (boxMax[axis] <= otherMin[axis] || boxMin[axis] >= otherMax[axis])
+                return false;
+            enter[axis] = -INFINITY;
+            exit[axis] = INFINITY;
+        }
+        else
+        {
+            const float a = (otherMin[axis] - boxMax[axis]) / d;
+            const float b = (otherMax[axis] - boxMin[axis]) / d;
+            enter[axis] = std::min(a, b);
+            exit[axis] = std::max(a, b);
+        }
+    }
+    const float timeEnter = std::max(enter[0], enter[1]);
+    const float timeExit = std::min(exit[0], exit[1]);
+    // Entering before the move started is overlapping already, leaving as soon as they enter is only grazing
+    if (timeEnter >= timeExit || timeEnter < 0.f || timeEnter > 1.f)
+        return false;
+    time = timeEnter;
+    normal = enter[0] > enter[1] ? vec2(displacement.x > 0.f ? -1.f : 1.f, 0.f)
+                                 : vec2(0.f, displacement.y > 0.f ? -1.f : 1.f);
+    return true;
+}
+
+bool SweepTiles(const TileGrid& grid, vec2 boxMin, vec2 boxMax, vec2 displacement, TileSweepHit& hit, u8 blockingFlags)
+{
+    auto blocks = [&](int x, int y)
+    {
+        return grid.Has(x, y, blockingFlags) || ((blockingFlags & TILE_SOLID) && grid.OnBorder(x, y));
+    };
+
+    // Every tile the box passes over, a handful for a projectile's step
+    const vec2 endMin = boxMin + displacement;
+    const vec2 endMax = boxMax + displacement;
+    const int x0 = grid.TileX(std::min(boxMin.x, endMin.x));
+    const int y0 = grid.TileY(std::min(boxMin.y, endMin.y));
+    const int x1 = grid.TileX(std::max(boxMax.x, endMax.x));
+    const int y1 = grid.TileY(std::max(boxMax.y, endMax.y));
+    const float tileSize = grid.tileSize;
+
+    bool found = false;
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+        {
+            if (!blocks(x, y))
+                continue;
+            const vec2 tileMin((float)x * tileSize, (float)y * tileSize);
+            float time;
+            vec2 normal;
+            if (!SweepBox(boxMin, boxMax, displacement, tileMin, tileMin + vec2(tileSize), time, normal))
+                continue;
+            if (found && time >= hit.time)
+                continue;
+            // Inside the wall, the box can't get to this face without going through the neighbour first
+            if (blocks(x + (int)normal.x, y + (int)normal.y))
+                continue;
+            found = true;
+            hit.tileX = x;
+            hit.tileY = y;
+            hit.time = time;
+            hit.normal = normal;
+        }
+    return found;
+}
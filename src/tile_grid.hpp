@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// What a tile of the stage is, a tile can be more than one (a ladder over a spike..)
+enum TileFlags : u8
+{
+    TILE_SOLID    = 1 << 0, // level geometry, blocks movement
+    TILE_LADDER   = 1 << 1,
+    TILE_SPIKE    = 1 << 2,
+    TILE_ENDPOINT = 1 << 3, // the exit to the next stage
+};
+
+// The current stage's tiles, one byte of TileFlags each, row-major. Built by the level module when it
+// generates a stage and never changed afterwards: AI, physics and rendering hold on to the one they were
+// handed and only read it, a new stage is a new grid.
+struct TileGrid
+{
+    u32 width = 0;
+    u32 height = 0;
+    float tileSize = 16.f; // pixels, tile (x, y) covers [x, x + 1) * tileSize horizontally
+    std::vector<u8> flags; // flags[y * width + x]
+    bool solidBorder = false; // the ring of tiles just outside the grid is solid too, stages walled in by boundary tiles
+
+    void Reset(u32 newWidth, u32 newHeight, float newTileSize)
+    {
+        width = newWidth;
+        height = newHeight;
+        tileSize = newTileSize;
+        flags.assign(width * height, 0);
+        solidBorder = false;
+    }
+
+    bool InBounds(int x, int y) const { return x >= 0 && y >= 0 && x < (int)width && y < (int)height; }
+    // 0 outside of the grid
+    u8 FlagsAt(int x, int y) const { return InBounds(x, y) ? flags[y * width + x] : 0; }
+    bool Has(int x, int y, u8 flag) const { return (FlagsAt(x, y) & flag) != 0; }
+    bool IsSolid(int x, int y) const { return Has(x, y, TILE_SOLID); }
+    // Inside the grid and not solid
+    bool IsFree(int x, int y) const { return InBounds(x, y) && !(flags[y * width + x] & TILE_SOLID); }
+    // On the solid ring around the grid, if it has one
+    bool OnBorder(int x, int y) const
+    {
+        return solidBorder && !InBounds(x, y) && x >= -1 && y >= -1 && x <= (int)width && y <= (int)height;
+    }
+    // The tile a point in pixels is in
+    int TileX(float x) const { return (int)std::floor(x / tileSize); }
+    int TileY(float y) const { return (int)std::floor(y / tileSize); }
+
+    void Add(int x, int y, u8 flag)
+    {
+        if (InBounds(x, y))
+            flags[y * width + x] |= flag;
+    }
+};
+
+// The grid of the stage that was generated last, see levels.cpp
+std::shared_ptr<const TileGrid> GetLevelGrid();
+
+struct TileRayHit
+{
+    int tileX = 0;
+    int tileY = 0;
+    float distance = 0.f;        // pixels from the origin to where the ray enters the tile
+    vec2 point = { 0.f, 0.f };
+    vec2 normal = { 0.f, 0.f };  // of the face that was hit, zero if the ray started inside the tile
+};
+
+// Walks the tiles a ray passes through in order (DDA, one step per tile boundary crossed, no sampling) and
+// stops at the first one with any of 'blockingFlags'. Positions and distances are in pixels, tiles outside
+// the grid never block. False if nothing is hit within maxDistance.
+bool RaycastTiles(const TileGrid& grid, vec2 origin, vec2 direction, float maxDistance, TileRayHit& hit, u8 blockingFlags = TILE_SOLID);
+
+// Nothing with 'blockingFlags' between the two points, for vision and aiming
+bool HasLineOfSight(const TileGrid& grid, vec2 from, vec2 to, u8 blockingFlags = TILE_SOLID);
+
+struct TileSweepHit
+{
+    int tileX = 0;
+    int tileY = 0;
+    float time = 0.f;            // fraction of the displacement the box moves before it touches the tile
+    vec2 normal = { 0.f, 0.f };  // of the face that was hit
+};
+
+// Time of impact of the box [boxMin, boxMax] moving by 'displacement' with the box [otherMin, otherMax] standing
+// still, as a fraction of the displacement. False if they don't meet on the way, or already overlap where it starts.
+bool SweepBox(vec2 boxMin, vec2 boxMax, vec2 displacement, vec2 otherMin, vec2 otherMax, float& time, vec2& normal);
+
+// The first tile with 'blockingFlags' the box [boxMin, boxMax] runs into when moved by 'displacement', for things
+// fast enough to get through a tile in one step. Tiles the box already overlaps don't count, nor faces shared
+// with another blocking tile (the seams of a floor). The solid border of the grid blocks like TILE_SOLID.
+bool SweepTiles(const TileGrid& grid, vec2 boxMin, vec2 boxMax, vec2 displacement, TileSweepHit& hit, u8 blockingFlags = TILE_SOLID);
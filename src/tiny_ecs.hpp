@@ -14,20 +14,125 @@
 
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
+#include <memory>
 #include <set>
 #include <functional>
 #include <typeindex>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
 #include <assert.h>
 
 typedef uint8_t       u8;
 typedef uint32_t      u32;
+typedef uint64_t      u64;
+
+// Everything ECSRegistry::save_snapshot captures. Plain data is appended to 'bytes' and read back in the same
+// order. Components that can't be memcpy'd (they hold a std::vector, std::string or std::function) are copied
+// into 'objects' instead, one array per container. Keep one snapshot around and re-use it: the buffers keep
+// their capacity and the objects are assigned over, so saving the same registry again barely allocates.
+struct RegistrySnapshot
+{
+	std::vector<u8> bytes;
+	std::vector<std::shared_ptr<void>> objects;
+	size_t read_pos = 0;
+	size_t object_pos = 0;
+
+	bool empty() const { return bytes.empty(); }
+
+	// Keeps the objects around to be assigned over by the next save
+	void clear()
+	{
+		bytes.clear();
+		rewind();
+	}
+
+	void rewind()
+	{
+		read_pos = 0;
+		object_pos = 0;
+	}
+
+	void write(const void* data, size_t size)
+	{
+		const u8* first = static_cast<const u8*>(data);
+		bytes.insert(bytes.end(), first, first + size);
+	}
+
+	void read(void* data, size_t size)
+	{
+		assert(read_pos + size <= bytes.size() && "Reading past the end of the snapshot");
+		if (size)
+			memcpy(data, &bytes[read_pos], size);
+		read_pos += size;
+	}
+
+	template <typename T>
+	void write_value(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be memcpy'd");
+		write(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void read_value(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be memcpy'd");
+		read(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void write_vector(const std::vector<T>& v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be memcpy'd");
+		write_value((u32)v.size());
+		write(v.data(), v.size() * sizeof(T));
+	}
+
+	template <typename T>
+	void read_vector(std::vector<T>& v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be memcpy'd");
+		u32 n;
+		read_value(n);
+		v.resize(n);
+		read(v.data(), n * sizeof(T));
+	}
+
+	// Serializer hook for the rest: a copy made with the copy constructor.
+	// Objects are written in the same order every time, so the one already in this slot is of the same type.
+	template <typename T>
+	void write_object(const T& object)
+	{
+		if (object_pos < objects.size())
+			*static_cast<T*>(objects[object_pos].get()) = object;
+		else
+			objects.push_back(std::make_shared<T>(object));
+		++object_pos;
+	}
+
+	template <typename T>
+	void read_object(T& object)
+	{
+		assert(object_pos < objects.size() && "Reading past the end of the snapshot");
+		object = *static_cast<const T*>(objects[object_pos++].get());
+	}
+};
 
 // Unique identifier for all entities
+// IDs of destroyed entities go on a free list and get handed out again. Every ID has a generation
+// counter that is bumped when it is destroyed, so a handle that outlived its entity (e.g. a
+// HolderComponent::near_weapon pointing at an item that got removed) no longer matches anything.
 class Entity
 {
     u32 tagAndId = 0; // First 8 bits are TAG, next 24 bits are ID
+    u32 generation = 0;
     static u32 id_count;
+    static std::vector<u32> id_generations; // current generation of every ID ever handed out
+    static std::vector<u32> free_ids;
 
 public:
 	Entity()
@@ -37,8 +142,23 @@ public:
 
     static Entity CreateEntity()
     {
+        u32 id;
+        if (!free_ids.empty())
+        {
+            // Take the most recently freed ID so the IDs in use stay small and dense
+            id = free_ids.back();
+            free_ids.pop_back();
+        }
+        else
+        {
+            id = ++id_count;
+            assert(id <= 0x00FFFFFF && "Ran out of entity IDs");
+            id_generations.resize(id + 1, 0);
+        }
+
         Entity e;
-        e.tagAndId = (0x00FFFFFF & ++id_count);
+        e.tagAndId = (0x00FFFFFF & id);
+        e.generation = id_generations[id];
         return e;
     }
 
@@ -49,6 +169,43 @@ public:
         return e;
     }
 
+    // Releases the ID for re-use. Returns false if the handle was already stale.
+    static bool DestroyEntity(Entity e)
+    {
+        if (!e.IsAlive())
+            return false;
+
+        u32 id = 0x00FFFFFF & e.tagAndId;
+        ++id_generations[id];
+        free_ids.push_back(id);
+        return true;
+    }
+
+    // Destroys every entity at once, all handles go stale. Every ID goes back on the free list, smallest on top.
+    // One pass over the IDs instead of one DestroyEntity per entity, see ECSRegistry::clear_stage
+    static void DestroyAllEntities()
+    {
+        free_ids.clear();
+        for (u32 id = id_count; id > 1; --id)
+        {
+            ++id_generations[id];
+            free_ids.push_back(id);
+        }
+    }
+
+    // False for the null entity and for handles whose ID has been destroyed (and maybe re-used) since
+    bool IsAlive() const
+    {
+        u32 id = 0x00FFFFFF & tagAndId;
+        return id != 0 && id < id_generations.size() && id_generations[id] == generation;
+    }
+
+    // Same ID and same generation, the tag is ignored
+    bool IsSameAs(const Entity& other) const
+    {
+        return ((0x00FFFFFF & tagAndId) == (0x00FFFFFF & other.tagAndId)) && generation == other.generation;
+    }
+
     void SetTag(u8 tag)
     {
     	tagAndId = (tag << 24) | (0x00FFFFFF & tagAndId);
@@ -64,77 +221,325 @@ public:
     	return tagAndId;
     }
 
-	void operator= (const Entity& other)
-	{
-		tagAndId = other.tagAndId;
-	}
+    // The ID alone, what the containers index by. Handles have no conversion to an integer: comparing two IDs
+    // would take a destroyed entity for the one that re-used its ID, compare handles with IsSameAs instead.
+    u32 GetID() const
+    {
+        return 0x00FFFFFF & tagAndId;
+    }
 
-    operator unsigned int() // this enables automatic casting to int
+    u32 GetGeneration() const
     {
-    	return(0x00FFFFFF & tagAndId); 
+        return generation;
     }
+
+    // The ID allocator is part of a registry snapshot, restoring it brings back the exact same handles
+    static void SaveAllocator(RegistrySnapshot& s)
+    {
+        s.write_value(id_count);
+        s.write_vector(id_generations);
+        s.write_vector(free_ids);
+    }
+
+    static void LoadAllocator(RegistrySnapshot& s)
+    {
+        s.read_value(id_count);
+        s.read_vector(id_generations);
+        s.read_vector(free_ids);
+    }
+};
+
+// Which containers every entity ID has a component in, one bit per container registered in the ECS registry.
+// Lets the registry destroy an entity by visiting only the containers it owns, and test several types at once.
+struct EntitySignatures
+{
+	static std::vector<u64> masks; // indexed by entity ID
+
+	static u64 get(u32 id)
+	{
+		return id < masks.size() ? masks[id] : 0;
+	}
+
+	static void add(u32 id, u64 bits)
+	{
+		if (id >= masks.size())
+			masks.resize(id + 1, 0);
+		masks[id] |= bits;
+	}
+
+	static void remove(u32 id, u64 bits)
+	{
+		if (id < masks.size())
+			masks[id] &= ~bits;
+	}
+
+	static void save(RegistrySnapshot& s) { s.write_vector(masks); }
+	static void load(RegistrySnapshot& s) { s.read_vector(masks); }
+};
+
+// Notified by the containers an OwningGroup owns, so it can keep its entities packed at the front of them
+struct GroupInterface
+{
+	virtual void on_insert(Entity e) = 0; // after e was added to one of the owned containers
+	virtual void on_remove(Entity e) = 0; // before e is removed from one of the owned containers
+	virtual void on_clear() = 0;
+};
+
+// Global counter for ComponentContainer::versions. A slot is stamped with the current tick when a component is
+// inserted, marked changed, or moved into it. A system that wants to do work only for what changed keeps the
+// tick it last caught up to:
+//     container.each_changed_since(lastTick, [&](u32 i) { ... });
+//     lastTick = ChangeTick::Advance(); // everything so far is <= lastTick, whatever changes next is newer
+struct ChangeTick
+{
+	static u32 current;
+
+	static u32 Advance()
+	{
+		return current++;
+	}
+};
+
+// Sparse array from the 24-bit entity ID to an index into a dense array.
+// The ID space is split into fixed size pages that are only allocated once an ID inside them
+// is used, so has / get / remove are one or two array reads instead of a hash map lookup.
+class SparseEntityIndex
+{
+public:
+	static const u32 INVALID = 0xFFFFFFFF;
+	static const u32 PAGE_BITS = 10;
+	static const u32 PAGE_SIZE = 1 << PAGE_BITS;
+	static const u32 PAGE_MASK = PAGE_SIZE - 1;
+
+	inline u32 find(u32 id) const
+	{
+		u32 page = id >> PAGE_BITS;
+		if (page >= pages.size() || !pages[page])
+			return INVALID;
+		return pages[page][id & PAGE_MASK];
+	}
+
+	inline void set(u32 id, u32 denseIndex)
+	{
+		u32 page = id >> PAGE_BITS;
+		if (page >= pages.size())
+			pages.resize(page + 1);
+		if (!pages[page])
+		{
+			pages[page].reset(new u32[PAGE_SIZE]);
+			std::fill(pages[page].get(), pages[page].get() + PAGE_SIZE, (u32)INVALID); // cast so INVALID is not odr-used
+		}
+		pages[page][id & PAGE_MASK] = denseIndex;
+	}
+
+	inline void reset(u32 id)
+	{
+		u32 page = id >> PAGE_BITS;
+		if (page < pages.size() && pages[page])
+			pages[page][id & PAGE_MASK] = INVALID;
+	}
+
+	// Keeps the pages around since the same IDs usually get used again right away (e.g. next stage)
+	void clear()
+	{
+		for (auto& page : pages)
+			if (page)
+				std::fill(page.get(), page.get() + PAGE_SIZE, (u32)INVALID);
+	}
+
+private:
+	std::vector<std::unique_ptr<u32[]>> pages;
+};
+
+// std::vector<bool> is bit packed and can't hand out a bool&, so struct-of-arrays bool fields use this
+struct SoABool
+{
+	bool value;
+};
+
+// Opt-in struct-of-arrays storage: one contiguous array per field instead of an array of structs.
+// A component opts in by declaring two nested types (see TransformComponent):
+//     Columns - the arrays, with push_back / pop_back / clear / reserve / for_each_column
+//     Ref     - an accessor with a reference member per field, constructed from (Columns&, index),
+//               assignable from and convertible to the component. Not copyable, always use Ref&.
+// Every slot has a Ref built into it, so components[i].position and auto& t = container.get(e) keep
+// working, while kernels that only need a field or two stream components.columns directly.
+template <typename Component>
+class SoAStorage
+{
+public:
+	typedef typename Component::Ref Ref;
+
+	typename Component::Columns columns;
+
+	SoAStorage() {}
+	SoAStorage(const SoAStorage&) = delete;
+	SoAStorage& operator=(const SoAStorage&) = delete;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	Ref& operator[](size_t i) { return refs()[i]; }
+	Ref& back() { return refs()[count - 1]; }
+	Ref* begin() { return refs(); }
+	Ref* end() { return refs() + count; }
+
+	void push_back(const Component& c)
+	{
+		if (count == capacity)
+			reserve(capacity ? capacity * 2 : 64);
+		columns.push_back(c);
+		new (&refSlots[count]) Ref(columns, count);
+		++count;
+	}
+
+	void pop_back()
+	{
+		columns.pop_back();
+		--count;
+	}
+
+	void clear()
+	{
+		columns.clear();
+		count = 0;
+	}
+
+	// All columns grow together here and only here, so the references held by the Refs stay valid in between
+	void reserve(size_t n)
+	{
+		if (n <= capacity)
+			return;
+		columns.reserve(n);
+		refSlots.reset(new RefSlot[n]);
+		capacity = n;
+		for (size_t i = 0; i < count; ++i)
+			new (&refSlots[i]) Ref(columns, i);
+	}
+
+	// Snapshots memcpy column by column
+	void save(RegistrySnapshot& s)
+	{
+		columns.for_each_column([&](const auto& column) { s.write_vector(column); });
+	}
+
+	void load(RegistrySnapshot& s, size_t n)
+	{
+		clear();
+		reserve(n); // so reading the columns doesn't reallocate under the Refs
+		columns.for_each_column([&](auto& column) { s.read_vector(column); });
+		for (size_t i = 0; i < n; ++i)
+			new (&refSlots[i]) Ref(columns, i);
+		count = n;
+	}
+
+private:
+	typedef typename std::aligned_storage<sizeof(Ref), alignof(Ref)>::type RefSlot;
+	std::unique_ptr<RefSlot[]> refSlots;
+	size_t count = 0;
+	size_t capacity = 0;
+
+	Ref* refs() { return reinterpret_cast<Ref*>(refSlots.get()); }
+};
+
+// Picks SoAStorage for components that declare Columns, std::vector for everything else
+template <typename T>
+struct ComponentStorageVoid { typedef void type; };
+
+template <typename Component, typename = void>
+struct ComponentStorage
+{
+	typedef std::vector<Component> type;
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+template <typename Component>
+struct ComponentStorage<Component, typename ComponentStorageVoid<typename Component::Columns>::type>
 {
-	virtual void clear() = 0;
-	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+	typedef SoAStorage<Component> type;
 };
 
 // A container that stores components of type 'Component' and associated entities
 template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+class ComponentContainer
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
-	bool registered = false;
+	// The sparse set from Entity -> array index.
+	SparseEntityIndex entity_componentID; // the entity is cast to uint (24-bit ID) to index it.
 public:
+	// Bit of this container in EntitySignatures, assigned by the registry. 0 for containers outside the registry.
+	u64 signature_bit = 0;
+	// The group that decides the order of this container, if any (see OwningGroup)
+	GroupInterface* owning_group = nullptr;
+
+	typedef typename ComponentStorage<Component>::type Storage;
+	// Component& for array-of-structs storage, Component::Ref& for struct-of-arrays storage
+	typedef decltype(std::declval<Storage&>()[0]) Reference;
+	typedef typename std::remove_reference<Reference>::type* Pointer;
+
 	// Container of all components of type 'Component'
-	std::vector<Component> components;
+	Storage components;
 
 	// The corresponding entities
 	std::vector<Entity> entities;
 
+	// ChangeTick of the last change to every slot, see mark_changed / each_changed_since.
+	// Writing through get() or components[i] doesn't count, call mark_changed after changing something others may cache.
+	std::vector<u32> versions;
+
 	// Constructor that registers the type
 	ComponentContainer()
 	{
 	}
 
 	// Inserting a component c associated to entity e
-	inline Component& insert(Entity e, Component c, bool check_for_duplicates = true)
+	inline Reference insert(Entity e, Component c, bool check_for_duplicates = true)
 	{
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		entity_componentID.set(e.GetID(), (u32)components.size());
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
+		versions.push_back(ChangeTick::current);
+		if (signature_bit)
+			EntitySignatures::add(e.GetID(), signature_bit);
+		if (owning_group)
+		{
+			// The group may have moved the new component to the front
+			owning_group->on_insert(e);
+			return components[entity_componentID.find(e.GetID())];
+		}
 		return components.back();
 	};
 
 	// The emplace function takes the the provided arguments Args, creates a new object of type Component, and inserts it into the ECS system
 	template<typename... Args>
-	Component& emplace(Entity e, Args &&... args) {
+	Reference emplace(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...));
 	};
 	template<typename... Args>
-	Component& emplace_with_duplicates(Entity e, Args &&... args) {
+	Reference emplace_with_duplicates(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...), false);
 	};
 
 	// A wrapper to return the component of an entity
-	Component& get(Entity e) {
+	Reference get(Entity e) {
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return components[entity_componentID.find(e.GetID())];
 	}
 
 	// Check if entity has a component of type 'Component'
+	// A stale handle whose ID has been recycled fails the generation check against the stored entity.
 	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+		u32 cID = entity_componentID.find(entity.GetID());
+		return cID != SparseEntityIndex::INVALID && entities[cID].IsSameAs(entity);
+	}
+
+	// has() and get() in one lookup, nullptr if the entity doesn't have a component of type 'Component'
+	Pointer find(Entity e) {
+		u32 cID = entity_componentID.find(e.GetID());
+		if (cID == SparseEntityIndex::INVALID || !entities[cID].IsSameAs(e))
+			return nullptr;
+		return &components[cID];
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -142,19 +547,26 @@ public:
 	{
 		if (has(e))
 		{
+			if (owning_group)
+				owning_group->on_remove(e);
+
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			u32 cID = entity_componentID.find(e.GetID());
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			versions[cID] = ChangeTick::current;
+			entity_componentID.set(entities.back().GetID(), cID);
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			entity_componentID.reset(e.GetID());
 			components.pop_back();
 			entities.pop_back();
+			versions.pop_back();
+			if (signature_bit)
+				EntitySignatures::remove(e.GetID(), signature_bit);
 			// Note, one could mark the id for re-use
 		}
 	};
@@ -162,9 +574,15 @@ public:
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		if (signature_bit)
+			for (Entity e : entities)
+				EntitySignatures::remove(e.GetID(), signature_bit);
+		if (owning_group)
+			owning_group->on_clear();
+		entity_componentID.clear();
 		components.clear();
 		entities.clear();
+		versions.clear();
 	}
 
 	// Report the number of components of type 'Component'
@@ -173,19 +591,373 @@ public:
 		return components.size();
 	}
 
+	// Writes the entities and components, the sparse index is rebuilt from the entities on load.
+	// Doesn't touch EntitySignatures or the owning group, ECSRegistry::load_snapshot restores those.
+	void save(RegistrySnapshot& s)
+	{
+		s.write_vector(entities);
+		save_components(s, components);
+	}
+
+	void load(RegistrySnapshot& s)
+	{
+		entity_componentID.clear();
+		s.read_vector(entities);
+		load_components(s, components);
+		assert(components.size() == entities.size() && "Snapshot doesn't match the container");
+		versions.assign(entities.size(), ChangeTick::current); // everything may differ from before the load
+		for (u32 i = 0; i < (u32)entities.size(); ++i)
+			entity_componentID.set(entities[i].GetID(), i);
+	}
+
+	// Index of the entity's component in 'components' and 'entities', SparseEntityIndex::INVALID if it has none
+	u32 index_of(Entity e) {
+		u32 cID = entity_componentID.find(e.GetID());
+		if (cID == SparseEntityIndex::INVALID || !entities[cID].IsSameAs(e))
+			return SparseEntityIndex::INVALID;
+		return cID;
+	}
+
+	// Exchange two slots, keeping the sparse index up to date
+	void swap_slots(u32 a, u32 b)
+	{
+		if (a == b)
+			return;
+		Component tmp = std::move(components[a]);
+		components[a] = std::move(components[b]);
+		components[b] = std::move(tmp);
+		std::swap(entities[a], entities[b]);
+		versions[a] = versions[b] = ChangeTick::current;
+		entity_componentID.set(entities[a].GetID(), a);
+		entity_componentID.set(entities[b].GetID(), b);
+	}
+
+private:
+	// memcpy what can be memcpy'd, copy construct the rest (read_vector also needs a default constructor)
+	template <typename C>
+	using Memcpyable = std::integral_constant<bool, std::is_trivially_copyable<C>::value && std::is_default_constructible<C>::value>;
+
+	template <typename C>
+	static void save_components(RegistrySnapshot& s, std::vector<C>& c)
+	{
+		save_components(s, c, Memcpyable<C>());
+	}
+	template <typename C>
+	static void save_components(RegistrySnapshot& s, std::vector<C>& c, std::true_type) { s.write_vector(c); }
+	template <typename C>
+	static void save_components(RegistrySnapshot& s, std::vector<C>& c, std::false_type) { s.write_object(c); }
+	template <typename C>
+	static void save_components(RegistrySnapshot& s, SoAStorage<C>& c) { c.save(s); }
+
+	template <typename C>
+	void load_components(RegistrySnapshot& s, std::vector<C>& c)
+	{
+		load_components(s, c, Memcpyable<C>());
+	}
+	template <typename C>
+	void load_components(RegistrySnapshot& s, std::vector<C>& c, std::true_type) { s.read_vector(c); }
+	template <typename C>
+	void load_components(RegistrySnapshot& s, std::vector<C>& c, std::false_type) { s.read_object(c); }
+	template <typename C>
+	void load_components(RegistrySnapshot& s, SoAStorage<C>& c) { c.load(s, entities.size()); }
+
+public:
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// The comparison is between entities. Only an index permutation is allocated, the components are then
+	// moved into place following the cycles of the permutation, each component is moved at most twice.
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
-		// First sort the entity list as desired
-		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
+		assert(!owning_group && "The order of this container belongs to an OwningGroup");
+
+		// order[i] is the slot whose component should end up in slot i
+		std::vector<u32> order(entities.size());
+		for (u32 i = 0; i < (u32)order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](u32 a, u32 b) { return comparisonFunction(entities[a], entities[b]); });
+
+		for (u32 start = 0; start < (u32)order.size(); ++start)
+		{
+			if (order[start] == start)
+				continue;
+
+			Component tmp = std::move(components[start]);
+			Entity tmpEntity = entities[start];
+			u32 current = start;
+			while (order[current] != start)
+			{
+				u32 next = order[current];
+				components[current] = std::move(components[next]);
+				entities[current] = entities[next];
+				order[current] = current; // mark as placed
+				current = next;
+			}
+			components[current] = std::move(tmp);
+			entities[current] = tmpEntity;
+			order[current] = current;
+		}
+
+		// Fill the new sparse index
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+			entity_componentID.set(entities[i].GetID(), i);
+		std::fill(versions.begin(), versions.end(), ChangeTick::current);
+	}
+
+	void mark_changed(Entity e)
+	{
+		assert(has(e) && "Entity not contained in ECS registry");
+		versions[entity_componentID.find(e.GetID())] = ChangeTick::current;
+	}
+
+	void mark_changed_at(u32 i)
+	{
+		versions[i] = ChangeTick::current;
+	}
+
+	bool changed_since(u32 i, u32 tick) const
+	{
+		return versions[i] > tick;
+	}
+
+	// Calls func(index) for every slot that changed after 'tick'
+	template <typename Func>
+	void each_changed_since(u32 tick, Func func)
+	{
+		for (u32 i = 0; i < (u32)versions.size(); ++i)
+			if (versions[i] > tick)
+				func(i);
+	}
+};
+
+// Iterates the entities that have all of 'Components', e.g.
+//     registry.view<Enemy, SpriteComponent>().each([](Entity e, Enemy& enemy, SpriteComponent& sprite) { ... });
+// Struct-of-arrays components are passed as Component::Ref&.
+// Iteration is driven by whichever container is smallest, the others are only looked up by entity.
+// Don't add or remove components of the viewed types inside each(), the containers get packed on removal.
+template <typename... Components>
+class View
+{
+	std::tuple<ComponentContainer<Components>&...> containers;
+
+	template <typename Func, size_t... I>
+	void each_impl(Func& func, std::index_sequence<I...>)
+	{
+		using expand = int[];
+
+		const std::vector<Entity>* driver = nullptr;
+		size_t smallest = SIZE_MAX;
+		(void)expand{ 0, (std::get<I>(containers).entities.size() < smallest
+			? (smallest = std::get<I>(containers).entities.size(), driver = &std::get<I>(containers).entities, 0) : 0)... };
+
+		for (size_t i = 0; i < driver->size(); ++i)
+		{
+			Entity e = (*driver)[i];
+			std::tuple<typename ComponentContainer<Components>::Pointer...> found(std::get<I>(containers).find(e)...);
+			bool hasAll = true;
+			(void)expand{ 0, (hasAll = hasAll && std::get<I>(found) != nullptr, 0)... };
+			if (hasAll)
+				func(e, *std::get<I>(found)...);
+		}
+	}
+
+public:
+	View(ComponentContainer<Components>&... c) : containers(c...)
+	{
+	}
+
+	template <typename Func>
+	void each(Func func)
+	{
+		each_impl(func, std::index_sequence_for<Components...>());
+	}
+};
+
+// Keeps the entities that have all of 'Components' packed at the front of each of those containers, in the
+// same order. Slot i < size() then belongs to the same entity in every owned container, so they can be walked
+// together by index without any lookups:
+//     group.each([](Entity e, SpriteComponent& sprite, TransformComponent::Ref& transform, ...) { ... });
+// The order is maintained on every insert and remove by swapping slots. A container can only be owned by one
+// group and can't be sort()ed. Like View, don't add or remove components of the owned types inside each().
+// Note that inserting into an owned container can move the components of entities outside the group.
+template <typename... Components>
+class OwningGroup : public GroupInterface
+{
+	std::tuple<ComponentContainer<Components>&...> containers;
+	u32 count = 0;
+
+	template <size_t... I>
+	bool has_all(Entity e, std::index_sequence<I...>)
+	{
+		bool hasAll = true;
+		using expand = int[];
+		(void)expand{ 0, (hasAll = hasAll && std::get<I>(containers).has(e), 0)... };
+		return hasAll;
+	}
+
+	template <size_t... I>
+	void swap_into(Entity e, u32 slot, std::index_sequence<I...>)
+	{
+		using expand = int[];
+		(void)expand{ 0, (std::get<I>(containers).swap_slots(std::get<I>(containers).index_of(e), slot), 0)... };
+	}
+
+	template <typename Func, size_t... I>
+	void each_impl(Func& func, std::index_sequence<I...>)
+	{
+		const std::vector<Entity>& entities = std::get<0>(containers).entities;
+		for (u32 i = 0; i < count; ++i)
+			func(entities[i], std::get<I>(containers).components[i]...);
+	}
+
+public:
+	OwningGroup(ComponentContainer<Components>&... c) : containers(c...)
+	{
+		using expand = int[];
+		(void)expand{ 0, (assert(!c.owning_group && "Container is already owned by another group"), c.owning_group = this, 0)... };
+		rebuild();
+	}
+
+	// Pulls in the entities that have everything. Keeps the order of a container that's already packed
+	// (e.g. just restored from a snapshot), since members then already sit at [0, count).
+	void rebuild()
+	{
+		count = 0;
+		const std::vector<Entity>& entities = std::get<0>(containers).entities;
+		for (size_t i = 0; i < entities.size(); ++i)
+			on_insert(entities[i]);
+	}
+
+	~OwningGroup()
+	{
+		using expand = int[];
+		(void)expand{ 0, (std::get<ComponentContainer<Components>&>(containers).owning_group = nullptr, 0)... };
+	}
+
+	OwningGroup(const OwningGroup&) = delete;
+	OwningGroup& operator=(const OwningGroup&) = delete;
+
+	// Number of entities in the group, they occupy slots [0, size()) of every owned container
+	u32 size() const { return count; }
+
+	template <typename Func>
+	void each(Func func)
+	{
+		each_impl(func, std::index_sequence_for<Components...>());
+	}
+
+	void on_insert(Entity e) override
+	{
+		if (!has_all(e, std::index_sequence_for<Components...>()))
+			return;
+		if (std::get<0>(containers).index_of(e) < count)
+			return; // already in the group
+		swap_into(e, count, std::index_sequence_for<Components...>());
+		++count;
+	}
+
+	void on_remove(Entity e) override
+	{
+		// Only group members live in front of 'count'
+		if (std::get<0>(containers).index_of(e) >= count)
+			return;
+		--count;
+		swap_into(e, count, std::index_sequence_for<Components...>());
+	}
+
+	void on_clear() override
+	{
+		count = 0;
+	}
+};
+
+// Position of T in Ts..., a compile error if T isn't one of them
+template <typename T, typename... Ts>
+struct TypeIndex;
+
+template <typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...> : std::integral_constant<size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+template <typename... Components>
+struct ComponentList {};
+
+// One ComponentContainer per type of a ComponentList, all in one tuple. Bulk operations are expanded over the
+// tuple at compile time, so there is no list of container pointers to maintain and no virtual call involved.
+// Container i owns bit i of EntitySignatures. container<T>() for a T that isn't in the list doesn't compile.
+template <typename List>
+class ComponentRegistry;
+
+template <typename... Components>
+class ComponentRegistry<ComponentList<Components...>>
+{
+	static_assert(sizeof...(Components) <= 64, "EntitySignatures has one bit per container");
+
+	std::tuple<ComponentContainer<Components>...> containers;
+
+	template <typename Func, size_t... I>
+	void for_each_container_impl(Func& func, std::index_sequence<I...>)
+	{
+		using expand = int[];
+		(void)expand{ 0, (func(std::get<I>(containers)), 0)... };
+	}
+
+	template <size_t... I>
+	void remove_by_signature(Entity e, u64 signature, std::index_sequence<I...>)
+	{
+		using expand = int[];
+		(void)expand{ 0, ((signature & ((u64)1 << I)) ? (std::get<I>(containers).remove(e), 0) : 0)... };
+	}
+
+	static constexpr u64 bits_of() { return 0; }
+
+	template <typename C, typename... Cs>
+	static constexpr u64 bits_of(C*, Cs*... rest)
+	{
+		return ((u64)1 << TypeIndex<C, Components...>::value) | bits_of(rest...);
+	}
+
+public:
+	ComponentRegistry()
+	{
+		u64 bit = 1;
+		for_each_container([&](auto& c) { c.signature_bit = bit; bit <<= 1; });
+	}
+
+	ComponentRegistry(const ComponentRegistry&) = delete;
+	ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+	// The container that stores 'Component'
+	template <typename Component>
+	ComponentContainer<Component>& container()
+	{
+		return std::get<TypeIndex<Component, Components...>::value>(containers);
+	}
+
+	// Calls func(container) for every container in list order, func has to take any ComponentContainer<T>&
+	template <typename Func>
+	void for_each_container(Func func)
+	{
+		for_each_container_impl(func, std::index_sequence_for<Components...>());
+	}
+
+	// The EntitySignatures bits of 'Cs', known at compile time
+	template <typename... Cs>
+	static constexpr u64 signature_of()
+	{
+		return bits_of((Cs*)nullptr...);
+	}
+
+	void clear_all_components()
+	{
+		for_each_container([](auto& c) { c.clear(); });
+	}
+
+	// Removes the entity from every container set in its signature, without freeing its ID
+	void remove_components_of(Entity e)
+	{
+		remove_by_signature(e, EntitySignatures::get(e.GetID()), std::index_sequence_for<Components...>());
 	}
 };
 
@@ -195,5 +967,9 @@ public:
 
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
 unsigned int Entity::id_count = 1;
+std::vector<u32> Entity::id_generations;
+std::vector<u32> Entity::free_ids;
+std::vector<u64> EntitySignatures::masks;
+u32 ChangeTick::current = 1;
 
 #endif
@@ -1,3 +1,80 @@
 #include "tiny_ecs_registry.hpp"
 
-ECSRegistry registry;
\ No newline at end of file
+ECSRegistry registry;
+
+void ECSRegistry::flush_commands()
+{
+	// Creates first, an entity created and destroyed in the same frame needs to exist before it can go away.
+	// Index loop because a create callback is allowed to defer more creates.
+	for (size_t i = 0; i < pending_creates.size(); ++i)
+		pending_creates[i]();
+	pending_creates.clear();
+
+	if (pending_destroys.empty())
+		return;
+
+	// Sort by ID and drop duplicates and handles that died some other way in the meantime,
+	// then remove container by container so each sparse index is walked in order.
+	std::sort(pending_destroys.begin(), pending_destroys.end(), [](Entity a, Entity b) {
+		u32 idA = a.GetID(); u32 idB = b.GetID();
+		return idA != idB ? idA < idB : a.GetGeneration() < b.GetGeneration();
+	});
+	pending_destroys.erase(std::unique(pending_destroys.begin(), pending_destroys.end(),
+		[](const Entity& a, const Entity& b) { return a.IsSameAs(b); }), pending_destroys.end());
+	pending_destroys.erase(std::remove_if(pending_destroys.begin(), pending_destroys.end(),
+		[](const Entity& e) { return !e.IsAlive(); }), pending_destroys.end());
+
+	for_each_container([&](auto& c) {
+		for (Entity e : pending_destroys)
+			if (EntitySignatures::get(e.GetID()) & c.signature_bit)
+				c.remove(e);
+	});
+	for (Entity e : pending_destroys)
+		Entity::DestroyEntity(e);
+
+	pending_destroys.clear();
+}
+
+void ECSRegistry::clear_stage()
+{
+	pending_creates.clear();
+	pending_destroys.clear();
+	contactBuffer.clear();
+	if (persistents.size() == 0)
+	{
+		clear_all_components();
+		Entity::DestroyAllEntities();
+		return;
+	}
+
+	// Some entities stay: destroy the others the way deferred destroys are, an entity without any
+	// component isn't in a container to be found and keeps its ID
+	const u64 persistentBit = persistents.signature_bit;
+	for_each_container([&](auto& c) {
+		for (Entity e : c.entities)
+			if (!(EntitySignatures::get(e.GetID()) & persistentBit))
+				pending_destroys.push_back(e);
+	});
+	flush_commands();
+}
+
+void ECSRegistry::save_snapshot(RegistrySnapshot& snapshot)
+{
+	snapshot.clear();
+	Entity::SaveAllocator(snapshot);
+	EntitySignatures::save(snapshot);
+	for_each_container([&](auto& c) { c.save(snapshot); });
+}
+
+void ECSRegistry::load_snapshot(RegistrySnapshot& snapshot)
+{
+	pending_creates.clear();
+	pending_destroys.clear();
+
+	snapshot.rewind();
+	Entity::LoadAllocator(snapshot);
+	EntitySignatures::load(snapshot);
+	for_each_container([&](auto& c) { c.load(snapshot); });
+	movingSprites.rebuild();
+	contactBuffer.clear(); // not part of a snapshot, the next physics step finds them again
+}
@@ -1,114 +1,362 @@
 #pragma once
+#include <algorithm>
 #include <vector>
+#include <mutex>
 
 #include "tiny_ecs.hpp"
 #include "components.hpp"
+#include "job_system.hpp"
 
-class ECSRegistry
+// Every component type this game has. Listing a type here is all it takes: it gets a container, a signature
+// bit and is part of clearing, destroying entities and snapshots. Using a type that isn't listed doesn't compile.
+typedef ComponentList<
+	TransformComponent,
+	MotionComponent,
+	CollisionComponent,
+	Player,
+	SpriteComponent,
+	DebugComponent,
+	HealthBar,
+	Enemy,
+	EnemyProjectile,
+	ActiveMutationsComponent,
+	Weapon,
+	HolderComponent,
+	Item,
+	ShopItem,
+	ActiveShopItem,
+	PathingBehavior,
+	PatrollingBehavior,
+	FlyingBehavior,
+	WalkingBehavior,
+	RangedBehavior,
+	MeleeBehavior,
+	VisionComponent,
+	DeathTimer,
+	PlayerProjectile,
+	ActivePlayerProjectile,
+	FastMover,
+	Persistent,
+	Exp,
+	Coin,
+	GoldBar,
+	ProximityTextComponent,
+	LightSource,
+	HealthPotion,
+	EnemyMeleeAttack,
+	Boss
+> GameComponents;
+
+// What every entity touched in the last physics step. PhysicsSystem adds the contacts in any order and sorts
+// them by entity once, after that each entity's contacts sit next to each other and contacts(e) is one sparse
+// index lookup: a range to walk instead of a scan over everyone's contacts. Cleared once
+// WorldSystem::handle_collisions has handled them.
+class ContactBuffer
+{
+public:
+	// One entity's contacts, in the order they were added
+	struct Range
+	{
+		const CollisionEvent* first = nullptr;
+		const CollisionEvent* last = nullptr;
+
+		const CollisionEvent* begin() const { return first; }
+		const CollisionEvent* end() const { return last; }
+		u32 size() const { return (u32)(last - first); }
+		bool empty() const { return first == last; }
+	};
+
+	// entities[i] touched events[i].other, grouped by entity after sort()
+	std::vector<Entity> entities;
+	std::vector<CollisionEvent> events;
+
+	size_t size() const { return events.size(); }
+
+	void add(Entity e, const CollisionEvent& contact)
+	{
+		entities.push_back(e);
+		events.push_back(contact);
+	}
+
+	// Groups everything added so far by entity (ordered by ID), each entity's contacts keep the order they were added in
+	void sort()
+	{
+		reset_index();
+		order.resize(entities.size());
+		for (u32 i = 0; i < (u32)order.size(); ++i)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [this](u32 a, u32 b) { return id_of(entities[a]) < id_of(entities[b]); });
+
+		sortedEntities.clear();
+		sortedEvents.clear();
+		for (u32 i : order)
+		{
+			sortedEntities.push_back(entities[i]);
+			sortedEvents.push_back(events[i]);
+		}
+		entities.swap(sortedEntities);
+		events.swap(sortedEvents);
+
+		for (u32 i = 0; i < (u32)entities.size(); ++i)
+		{
+			if (i == 0 || id_of(entities[i]) != id_of(entities[i - 1]))
+			{
+				index.set(id_of(entities[i]), (u32)runStart.size());
+				runStart.push_back(i);
+			}
+		}
+		runStart.push_back((u32)entities.size());
+	}
+
+	// What 'e' touched, empty if nothing (or if the contacts haven't been sorted since they were added)
+	Range contacts(Entity e) const
+	{
+		Range range;
+		u32 run = index.find(id_of(e));
+		if (run == SparseEntityIndex::INVALID || !entities[runStart[run]].IsSameAs(e))
+			return range;
+		range.first = events.data() + runStart[run];
+		range.last = events.data() + runStart[run + 1];
+		return range;
+	}
+
+	void clear()
+	{
+		reset_index();
+		entities.clear();
+		events.clear();
+	}
+
+private:
+	SparseEntityIndex index;   // entity ID -> its run
+	std::vector<u32> runStart; // entity of run r owns [runStart[r], runStart[r + 1])
+	std::vector<u32> order;
+	std::vector<Entity> sortedEntities;
+	std::vector<CollisionEvent> sortedEvents;
+
+	static u32 id_of(const Entity& e) { return e.GetTagAndID() & 0x00FFFFFF; }
+
+	void reset_index()
+	{
+		for (u32 run = 0; run + 1 < (u32)runStart.size(); ++run)
+			index.reset(id_of(entities[runStart[run]]));
+		runStart.clear();
+	}
+};
+
+// What a parallel loop does with a component type, see ECSRegistry::parallel_for_each
+template <typename T> struct Read { typedef T Component; static constexpr bool writes = false; };
+template <typename T> struct Write { typedef T Component; static constexpr bool writes = true; };
+
+class ECSRegistry : public ComponentRegistry<GameComponents>
 {
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
+	// Structural changes recorded by create_deferred / destroy_deferred
+	std::vector<std::function<void()>> pending_creates;
+	std::vector<Entity> pending_destroys;
+
+	// Read / write signatures of the parallel loops that are running right now (debug builds only)
+	struct ParallelAccess { u64 reads; u64 writes; };
+	std::mutex parallel_access_mutex;
+	std::vector<ParallelAccess> parallel_accesses;
+
+	template <typename First, typename... Rest>
+	struct FirstOf { typedef typename First::Component Component; };
+
+	void begin_parallel_access(u64 reads, u64 writes)
+	{
+#ifndef NDEBUG
+		std::lock_guard<std::mutex> lock(parallel_access_mutex);
+		for (const ParallelAccess& running : parallel_accesses)
+		{
+			assert(!(writes & (running.reads | running.writes)) && "two parallel loops write the same component type");
+			assert(!(reads & running.writes) && "a parallel loop reads a component type another one writes");
+		}
+		parallel_accesses.push_back({ reads, writes });
+#endif
+	}
+
+	void end_parallel_access(u64 reads, u64 writes)
+	{
+#ifndef NDEBUG
+		std::lock_guard<std::mutex> lock(parallel_access_mutex);
+		for (size_t i = 0; i < parallel_accesses.size(); ++i)
+			if (parallel_accesses[i].reads == reads && parallel_accesses[i].writes == writes)
+			{
+				parallel_accesses.erase(parallel_accesses.begin() + i);
+				break;
+			}
+#endif
+	}
 
 public:
-	// Manually created list of all components this game has
-	ComponentContainer<TransformComponent> transforms;
-	ComponentContainer<MotionComponent> motions;
-	ComponentContainer<CollisionComponent> colliders;
-	ComponentContainer<CollisionEvent> collisionEvents;
-	ComponentContainer<Player> players;
-	ComponentContainer<SpriteComponent> sprites;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<HealthBar> healthBar;
-	ComponentContainer<Enemy> enemy;
-	ComponentContainer<EnemyProjectile> enemyProjectiles;
-	ComponentContainer<ActiveMutationsComponent> mutations;
-    ComponentContainer<Weapon> weapons;
-    ComponentContainer<HolderComponent> holders;
-    ComponentContainer<Item> items;
-	ComponentContainer<ShopItem> shopItems;
-	ComponentContainer<ActiveShopItem> activeShopItems;
-	ComponentContainer<PathingBehavior> pathingBehaviors;
-	ComponentContainer<PatrollingBehavior> patrollingBehaviors;
-	ComponentContainer<FlyingBehavior> flyingBehaviors;
-	ComponentContainer<WalkingBehavior> walkingBehaviors;
-	ComponentContainer<RangedBehavior> rangedBehaviors;
-	ComponentContainer<MeleeBehavior> meleeBehaviors;
-	ComponentContainer<VisionComponent> visionComponents;
-	ComponentContainer<DeathTimer> deathTimers;
-    ComponentContainer<PlayerProjectile> playerProjectiles;
-    ComponentContainer<ActivePlayerProjectile> activePlayerProjectiles;
-	ComponentContainer<Exp> exp;
-	ComponentContainer<Coin> coins;
-	ComponentContainer<GoldBar> goldBar;
-	ComponentContainer<ProximityTextComponent> proximityTexts;
-	ComponentContainer<LightSource> lightSources;
-	ComponentContainer<HealthPotion> healthPotion;
-	ComponentContainer<EnemyMeleeAttack> enemyMeleeAttacks;
-	ComponentContainer<Boss> boss;
-
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
+	// The signature bits of the Write<> types among 'Access'
+	template <typename... Access>
+	static u64 write_signature_of()
+	{
+		u64 bits = 0;
+		using expand = int[];
+		(void)expand{ 0, (bits |= Access::writes ? signature_of<typename Access::Component>() : 0, 0)... };
+		return bits;
+	}
+
+	// Named access to the containers
+	ComponentContainer<TransformComponent>& transforms = container<TransformComponent>();
+	ComponentContainer<MotionComponent>& motions = container<MotionComponent>();
+	ComponentContainer<CollisionComponent>& colliders = container<CollisionComponent>();
+	ComponentContainer<Player>& players = container<Player>();
+	ComponentContainer<SpriteComponent>& sprites = container<SpriteComponent>();
+	ComponentContainer<DebugComponent>& debugComponents = container<DebugComponent>();
+	ComponentContainer<HealthBar>& healthBar = container<HealthBar>();
+	ComponentContainer<Enemy>& enemy = container<Enemy>();
+	ComponentContainer<EnemyProjectile>& enemyProjectiles = container<EnemyProjectile>();
+	ComponentContainer<ActiveMutationsComponent>& mutations = container<ActiveMutationsComponent>();
+    ComponentContainer<Weapon>& weapons = container<Weapon>();
+    ComponentContainer<HolderComponent>& holders = container<HolderComponent>();
+    ComponentContainer<Item>& items = container<Item>();
+	ComponentContainer<ShopItem>& shopItems = container<ShopItem>();
+	ComponentContainer<ActiveShopItem>& activeShopItems = container<ActiveShopItem>();
+	ComponentContainer<PathingBehavior>& pathingBehaviors = container<PathingBehavior>();
+	ComponentContainer<PatrollingBehavior>& patrollingBehaviors = container<PatrollingBehavior>();
+	ComponentContainer<FlyingBehavior>& flyingBehaviors = container<FlyingBehavior>();
+	ComponentContainer<WalkingBehavior>& walkingBehaviors = container<WalkingBehavior>();
+	ComponentContainer<RangedBehavior>& rangedBehaviors = container<RangedBehavior>();
+	ComponentContainer<MeleeBehavior>& meleeBehaviors = container<MeleeBehavior>();
+	ComponentContainer<VisionComponent>& visionComponents = container<VisionComponent>();
+	ComponentContainer<DeathTimer>& deathTimers = container<DeathTimer>();
+    ComponentContainer<PlayerProjectile>& playerProjectiles = container<PlayerProjectile>();
+    ComponentContainer<ActivePlayerProjectile>& activePlayerProjectiles = container<ActivePlayerProjectile>();
+	ComponentContainer<FastMover>& fastMovers = container<FastMover>();
+	ComponentContainer<Persistent>& persistents = container<Persistent>();
+	ComponentContainer<Exp>& exp = container<Exp>();
+	ComponentContainer<Coin>& coins = container<Coin>();
+	ComponentContainer<GoldBar>& goldBar = container<GoldBar>();
+	ComponentContainer<ProximityTextComponent>& proximityTexts = container<ProximityTextComponent>();
+	ComponentContainer<LightSource>& lightSources = container<LightSource>();
+	ComponentContainer<HealthPotion>& healthPotion = container<HealthPotion>();
+	ComponentContainer<EnemyMeleeAttack>& enemyMeleeAttacks = container<EnemyMeleeAttack>();
+	ComponentContainer<Boss>& boss = container<Boss>();
+
+	// Filled by PhysicsSystem every step, see ContactBuffer
+	ContactBuffer contactBuffer;
+	ContactBuffer::Range contacts(Entity e) const { return contactBuffer.contacts(e); }
+
+	// Everything that moves and is drawn sits at the front of sprites, transforms and motions, in the same order.
+	// MoveEntities and RenderSystem::Draw walk these by index instead of looking up the other containers.
+	OwningGroup<SpriteComponent, TransformComponent, MotionComponent> movingSprites;
+
 	ECSRegistry()
+		: movingSprites(sprites, transforms, motions)
+	{
+	}
+
+	// Iterate all entities that have every one of 'Components', see View in tiny_ecs.hpp
+	template <typename... Components>
+	View<Components...> view() {
+		return View<Components...>(container<Components>()...);
+	}
+
+	// Like view<>().each() but split into chunks of the first listed type's dense array and run across the job
+	// system. Every type touched has to be declared as Read or Write, the callback gets one reference per type:
+	//     registry.parallel_for_each<Write<SpriteComponent>, Read<TransformComponent>>(
+	//         [](Entity e, SpriteComponent& sprite, TransformComponent::Ref& transform) { ... });
+	// The callback runs on several threads at once, so it may only touch its own entity's components and must not
+	// make structural changes (insert / remove / deferred commands). Debug builds assert that no two loops running
+	// at the same time write the same type, or read a type the other one writes.
+	template <typename... Access, typename Func>
+	void parallel_for_each(Func func, u32 chunkSize = 256)
 	{
-		registry_list.push_back(&transforms);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&colliders);
-		registry_list.push_back(&collisionEvents);
-		registry_list.push_back(&players);
-		registry_list.push_back(&sprites);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&healthBar);
-		registry_list.push_back(&enemy);
-		registry_list.push_back(&enemyProjectiles);
-        registry_list.push_back(&mutations);
-        registry_list.push_back(&weapons);
-        registry_list.push_back(&holders);
-        registry_list.push_back(&items);
-		registry_list.push_back(&shopItems);
-		registry_list.push_back(&activeShopItems);
-		registry_list.push_back(&pathingBehaviors);
-		registry_list.push_back(&patrollingBehaviors);
-		registry_list.push_back(&flyingBehaviors);
-		registry_list.push_back(&walkingBehaviors);
-		registry_list.push_back(&rangedBehaviors);
-		registry_list.push_back(&meleeBehaviors);
-		registry_list.push_back(&visionComponents);
-		registry_list.push_back(&deathTimers);
-        registry_list.push_back(&playerProjectiles);
-        registry_list.push_back(&activePlayerProjectiles);
-		registry_list.push_back(&exp);
-		registry_list.push_back(&coins);
-		registry_list.push_back(&goldBar);
-		registry_list.push_back(&proximityTexts);
-		registry_list.push_back(&lightSources);
-		registry_list.push_back(&healthPotion);
-		registry_list.push_back(&enemyMeleeAttacks);
-		registry_list.push_back(&boss);
-		
-	}
-
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
+		auto& driver = container<typename FirstOf<Access...>::Component>();
+		parallel_for_range<Access...>([&](u32 begin, u32 end) {
+			for (u32 i = begin; i < end; ++i)
+			{
+				Entity e = driver.entities[i];
+				std::tuple<typename ComponentContainer<typename Access::Component>::Pointer...> found(
+					container<typename Access::Component>().find(e)...);
+				call_if_found(func, e, found, std::index_sequence_for<Access...>());
+			}
+		}, chunkSize);
 	}
 
+	// Same declarations as parallel_for_each, but func(begin, end) gets slot ranges of the first listed type,
+	// for kernels that walk its arrays (or SoA columns) directly
+	template <typename... Access, typename Func>
+	void parallel_for_range(Func func, u32 chunkSize = 256)
+	{
+		const u64 reads = signature_of<typename Access::Component...>();
+		const u64 writes = write_signature_of<Access...>();
+		begin_parallel_access(reads, writes);
+		parallel_for((u32)container<typename FirstOf<Access...>::Component>().size(), chunkSize, func);
+		end_parallel_access(reads, writes);
+	}
+
+	// Creating or destroying entities while a system iterates a container moves components around under it.
+	// Record those changes here instead, they are applied in one batch by flush_commands() at the end of the frame.
+	void destroy_deferred(Entity e) {
+		pending_destroys.push_back(e);
+	}
+
+	// 'create' runs during flush_commands(), it should call one of the create* functions
+	void create_deferred(std::function<void()> create) {
+		pending_creates.push_back(std::move(create));
+	}
+
+	void flush_commands();
+
+	// Entities live for one stage unless they have a Persistent component. Tears the stage down: every other
+	// entity is destroyed, handles to them go stale. With nothing persistent (the usual case, the player is
+	// re-created each stage and gets its lasting components carried over by WorldSystem::StartNewStage) that is
+	// emptying every container and releasing all entity IDs in bulk. The containers keep their memory either way.
+	void clear_stage();
+
+	// Capture / bring back the whole world: every container (entity arrays and components, the sparse indices
+	// are rebuilt from the entities), the entity signatures and the entity ID allocator, so every handle held
+	// anywhere means the same thing again after a load. Queued deferred commands are not part of a snapshot,
+	// loading drops them. State outside the registry (level data, system members) is up to the caller.
+	void save_snapshot(RegistrySnapshot& snapshot);
+	void load_snapshot(RegistrySnapshot& snapshot);
+
 	void list_all_components() {
 		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
+		for_each_container([](auto& c) {
+			if (c.size() > 0)
+				printf("%4d components of type %s\n", (int)c.size(), typeid(c).name());
+		});
 	}
 
 	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
+		printf("Debug info on components of entity %u:\n", e.GetID());
+		for_each_container([&](auto& c) {
+			if (c.has(e))
+				printf("type %s\n", typeid(c).name());
+		});
 	}
 
+	// Destroys the entity: removes every component it owns and frees its ID for re-use.
+	// Does nothing for a stale handle, since the ID might already belong to a new entity.
+	// Only the containers set in the entity's signature are visited.
 	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
+		if (!e.IsAlive())
+			return;
+		remove_components_of(e);
+		Entity::DestroyEntity(e);
+	}
+
+	// True if the entity has a component of every one of 'Components', one AND against its signature
+	template <typename... Components>
+	bool has(Entity e) {
+		const u64 bits = signature_of<Components...>();
+		return e.IsAlive() && (EntitySignatures::get(e.GetID()) & bits) == bits;
+	}
+
+private:
+	template <typename Func, typename Found, size_t... I>
+	static void call_if_found(Func& func, Entity e, Found& found, std::index_sequence<I...>)
+	{
+		bool hasAll = true;
+		using expand = int[];
+		(void)expand{ 0, (hasAll = hasAll && std::get<I>(found) != nullptr, 0)... };
+		if (hasAll)
+			func(e, *std::get<I>(found)...);
 	}
 };
 
@@ -131,9 +131,9 @@ void UISystem::UpdateTextUI(float dt)
         case MODE_INGAME:
         {
             Entity playerEntity = registry.players.entities[0];
-            TransformComponent& playerTransform = registry.transforms.get(playerEntity);
-            MotionComponent& playerMotion = registry.motions.get(playerEntity);
-            CollisionComponent& playerCollider = registry.colliders.get(playerEntity);
+            auto& playerTransform = registry.transforms.get(playerEntity);
+            auto& playerMotion = registry.motions.get(playerEntity);
+            auto& playerCollider = registry.colliders.get(playerEntity);
             HealthBar& playerHealth = registry.healthBar.get(playerEntity);
             GoldBar& playerGold = registry.goldBar.get(playerEntity);
 
@@ -405,8 +405,8 @@ Entity CreateBossRanged(vec2 position, bool start) {
 
         auto& currentBossEntity = registry.boss.entities[0];
         auto bossOld = registry.boss.get(currentBossEntity);
-        auto transformOld = registry.transforms.get(currentBossEntity);
-        auto motionOld = registry.motions.get(currentBossEntity);
+        TransformComponent transformOld = registry.transforms.get(currentBossEntity);
+        MotionComponent motionOld = registry.motions.get(currentBossEntity);
         auto hbOld = registry.healthBar.get(currentBossEntity);
 
         auto& boss = registry.boss.emplace(entity);
@@ -1107,6 +1107,7 @@ Entity createEnemyLobbingProjectile(vec2 position, vec2 velocity, vec2 accelerat
         projectile.attackPower = registry.rangedBehaviors.get(enemy).attackPower;
     }
     projectile.enemy_projectile = enemy;
+    registry.fastMovers.emplace(entity);
     registry.sprites.insert(
         entity,
         {
@@ -1142,6 +1143,7 @@ Entity createEnemyProjectile(vec2 position, vec2 velocity, Entity enemy) {
         projectile.attackPower = registry.rangedBehaviors.get(enemy).attackPower;
     }
     projectile.enemy_projectile = enemy;
+    registry.fastMovers.emplace(entity);
     if (registry.boss.has(enemy)) {
         if (velocity.x > 0) {
             auto& sprite = registry.sprites.insert(
@@ -5,6 +5,7 @@
 // stlib
 #include <cassert>
 #include <sstream>
+#include <chrono>
 
 #include "physics_system.hpp"
 #include "player_system.hpp"
@@ -218,6 +219,64 @@ WorldSystem::WorldSystem()
                 console_printf("'next_stage' command only works while in game...\n");   
             }
         });
+
+    get_console().bind_cmd("checkpoint",
+        [this](std::istream& is, std::ostream& os){
+            if(this->currentGameMode == MODE_INGAME)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                registry.save_snapshot(this->checkpoint);
+                this->checkpointStage = this->currentGameStage;
+                float ms = (float)(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start)).count() / 1000.f;
+                console_printf("Saved checkpoint: %d bytes in %.3f ms\n", (int)this->checkpoint.bytes.size(), ms);
+            }
+            else
+            {
+                console_printf("'checkpoint' command only works while in game...\n");
+            }
+        });
+
+    get_console().bind_cmd("rewind",
+        [this](std::istream& is, std::ostream& os){
+            if(this->currentGameMode != MODE_INGAME)
+            {
+                console_printf("'rewind' command only works while in game...\n");
+            }
+            else if(this->checkpoint.empty() || this->checkpointStage != this->currentGameStage)
+            {
+                console_printf("No checkpoint for this stage, use 'checkpoint' first...\n");
+            }
+            else
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                registry.load_snapshot(this->checkpoint);
+                float ms = (float)(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start)).count() / 1000.f;
+                console_printf("Restored checkpoint in %.3f ms\n", ms);
+            }
+        });
+
+    get_console().bind_cmd("ai_stats",
+        [this](std::istream& is, std::ostream& os){
+            this->aiSystem->PrintStats();
+        });
+
+    get_console().bind_cmd("ai_lockstep",
+        [this](std::istream& is, std::ostream& os){
+            u32 thinksPerTick = 0;
+            is >> thinksPerTick;
+            this->aiSystem->SetLockstep(thinksPerTick);
+            if (thinksPerTick) {
+                console_printf("AI lockstep ON: %u thinks per tick beyond the close ones, path results waited for\n", thinksPerTick);
+            } else {
+                console_printf("AI lockstep OFF: thinking on the time budget\n");
+            }
+        });
+
+    get_console().bind_cmd("stage_stats",
+        [this](std::istream& is, std::ostream& os){
+            console_printf("Last stage transition took %.2f ms (teardown of ~%d entities %.2f ms)\n",
+                this->lastTransitionMs, (int)this->lastTeardownEntities, this->lastTeardownMs);
+        });
 }
 
 void WorldSystem::HandleMutations() {
@@ -284,6 +343,8 @@ void WorldSystem::HelpMode() {
 
 void WorldSystem::StartNewStage(GAMELEVELENUM stage) {
 
+    auto stageTransitionStart = std::chrono::high_resolution_clock::now();
+
     Mix_HaltMusic();
 
 // SAVE PLAYER DATA
@@ -300,11 +361,11 @@ void WorldSystem::StartNewStage(GAMELEVELENUM stage) {
 
 // CLEAR STUFF FROM LAST STAGE
     // registry.list_all_components(); // Debugging for memory/component leaks
-    // Remove all entities that we created
-    while (registry.transforms.entities.size() > 0)
-        registry.remove_all_components_of(registry.transforms.entities.back());
-    while (registry.proximityTexts.entities.size() > 0)
-        registry.remove_all_components_of(registry.proximityTexts.entities.back());
+    // Remove all entities that we created. Whatever the last stage still had queued goes away with them.
+    lastTeardownEntities = registry.transforms.size() + registry.proximityTexts.size();
+    registry.clear_stage();
+    lastTeardownMs = (float)(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - stageTransitionStart)).count() / 1000.f;
+    checkpoint.clear(); // the level it was taken in is gone
     // registry.list_all_components(); // Debugging for memory/component leaks
 
 // CHECK IF GAME SHOULD END
@@ -322,7 +383,7 @@ void WorldSystem::StartNewStage(GAMELEVELENUM stage) {
 
     // Create random level
     GenerateNewLevel(stage);
-    aiSystem->Init(levelForAI());
+    aiSystem->Init(GetLevelGrid());
     renderer->cameraBoundMin = currentLevelData.cameraBoundMin;
     renderer->cameraBoundMax = currentLevelData.cameraBoundMax;
     SpawnLevelEntities();
@@ -387,6 +448,8 @@ void WorldSystem::StartNewStage(GAMELEVELENUM stage) {
         registry.goldBar.get(player) = playerGoldComponent;
         registry.mutations.get(player) = playerActiveMutationsComponent;
     }
+
+    lastTransitionMs = (float)(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - stageTransitionStart)).count() / 1000.f;
 }
 
 void WorldSystem::SpawnLevelEntities() {
@@ -572,18 +635,6 @@ void WorldSystem::unloadAllContent() {
     registry.clear_all_components();
 }
 
-std::vector<std::vector<int>> WorldSystem::levelForAI() {
-    std::vector<std::vector<int>> newLevelTiles;
-    for (int i = 0; i < levelTiles.size(); i++) {
-        std::vector<int> currentLayer;
-        for (int j = 0; j < levelTiles[0].size(); j++) {
-            currentLayer.push_back((levelTiles[i][j] != 0) ? 1 : 0);
-        }
-        newLevelTiles.push_back(currentLayer);
-    }
-    return newLevelTiles;
-}
-
 void WorldSystem::SetCurrentMode(GAMEMODE mode) {
     currentGameMode = mode;
 
@@ -666,7 +717,7 @@ bool WorldSystem::step(float deltaTime) {
         playerProjectileRegistry.components[i].elapsed_time += deltaTime;
 
         if (playerProjectileRegistry.components[i].elapsed_time > 5) {
-            registry.remove_all_components_of(playerProjectileRegistry.entities[i]);
+            registry.destroy_deferred(playerProjectileRegistry.entities[i]);
         }
     }
 
@@ -698,11 +749,11 @@ bool WorldSystem::step(float deltaTime) {
             Exp& counter = registry.exp.get(entity);
             counter.counter_seconds_exp -= deltaTime;
             if (counter.counter_seconds_exp < 0.f) {
-                registry.exp.remove(entity);
-                registry.remove_all_components_of(entity);
+                registry.destroy_deferred(entity);
+                continue;
             }
 
-            if(!registry.transforms.has(entity) || !registry.motions.has(entity))
+            if(!registry.has<TransformComponent, MotionComponent>(entity))
             {
                 continue;
             }
@@ -726,8 +777,7 @@ bool WorldSystem::step(float deltaTime) {
         counter1.counter_seconds_coin -= deltaTime;
 
         if (counter1.counter_seconds_coin < 0.f) {
-            registry.coins.remove(entity);
-            registry.remove_all_components_of(entity);
+            registry.destroy_deferred(entity);
         }
     }
 
@@ -737,8 +787,7 @@ bool WorldSystem::step(float deltaTime) {
         counter1.counter_seconds_health -= deltaTime;
 
         if (counter1.counter_seconds_health < 0.f) {
-            registry.healthPotion.remove(entity);
-            registry.remove_all_components_of(entity);
+            registry.destroy_deferred(entity);
         }
     }
 
@@ -750,20 +799,25 @@ void WorldSystem::handle_collisions() {
     bool bGoToNextStage = false;
 
     Player &playerComponent = registry.players.get(player);
-    TransformComponent &playerTransform = registry.transforms.get(player);
-    MotionComponent &playerMotion = registry.motions.get(player);
-    CollisionComponent &playerCollider = registry.colliders.get(player);
+    auto& playerTransform = registry.transforms.get(player);
+    auto& playerMotion = registry.motions.get(player);
+    auto& playerCollider = registry.colliders.get(player);
     HealthBar &playerHealth = registry.healthBar.get(player);
     GoldBar &playercoins = registry.goldBar.get(player);
 
     // Loop over all collisions detected by the physics system
-    auto &collisionsRegistry = registry.collisionEvents;
-    for (uint i = 0; i < collisionsRegistry.components.size(); i++) {
+    const auto &contactBuffer = registry.contactBuffer;
+    for (uint i = 0; i < contactBuffer.size(); i++) {
 
-        const CollisionEvent colEvent = collisionsRegistry.components[i];
-        Entity entity = collisionsRegistry.entities[i];
+        const CollisionEvent colEvent = contactBuffer.events[i];
+        Entity entity = contactBuffer.entities[i];
         Entity entity_other = colEvent.other;
 
+        // Lost its collider to an earlier contact this step (an enemy that just died), the rest of its contacts are void
+        if (!registry.colliders.has(entity)) {
+            continue;
+        }
+
         if (registry.enemy.has(entity)) {
             bool is_thrown_weapon = registry.items.has(entity_other)
                                     && registry.activePlayerProjectiles.has(entity_other)
@@ -811,8 +865,7 @@ void WorldSystem::handle_collisions() {
                 {
                     registry.deathTimers.emplace(entity);
                     registry.colliders.remove(entity);
-                    registry.collisionEvents.remove(entity);
-                    MotionComponent &motion = registry.motions.get(entity);
+                    auto& motion = registry.motions.get(entity);
                     motion.acceleration = {0.f, 0.f};
                     motion.velocity = {0.f, 0.f};
 
@@ -858,7 +911,7 @@ void WorldSystem::handle_collisions() {
 
 
         if (registry.players.has(entity)) {
-            CheckCollisionWithBlockable(entity, entity_other);
+            CheckCollisionWithBlockable(entity, colEvent);
 
             if (entity_other.GetTag() == TAG_SPIKE) {
                 if (playerMotion.velocity.y > 0.f && playerComponent.damageCooldown <= 0.f) // only hurt when falling on spikes
@@ -969,18 +1022,18 @@ void WorldSystem::handle_collisions() {
         }
 
         if (registry.enemy.has(entity)) {
-            CheckCollisionWithBlockable(entity, entity_other);
+            CheckCollisionWithBlockable(entity, colEvent);
         }
 
         if (registry.exp.has(entity) || registry.coins.has(entity) || registry.healthPotion.has(entity))
         {
-            CheckCollisionWithBlockable(entity, entity_other);
+            CheckCollisionWithBlockable(entity, colEvent);
         }
 
         if (registry.holders.has(entity)) {
             HolderComponent &holder = registry.holders.get(entity);
 
-            if (entity_other.GetTagAndID() != 0 && entity_other != holder.held_weapon && registry.items.has(entity_other) && registry.items.get(entity_other).pickable && !registry.playerProjectiles.has(entity_other))
+            if (entity_other.GetTagAndID() != 0 && !entity_other.IsSameAs(holder.held_weapon) && registry.items.has(entity_other) && registry.items.get(entity_other).pickable && !registry.playerProjectiles.has(entity_other))
             {
                 holder.near_weapon = entity_other;
             }
@@ -994,12 +1047,12 @@ void WorldSystem::handle_collisions() {
             {
                 if(!registry.playerProjectiles.has(entity) || registry.playerProjectiles.get(entity).elapsed_time > 0.01f)
                 {
-                    CheckCollisionWithBlockable(entity, entity_other, item.friction, true);
+                    CheckCollisionWithBlockable(entity, colEvent, item.friction, true);
                 }
 
                 if(entity_other.GetTag() == TAG_PLAYERBLOCKABLE)
                 {
-                    MotionComponent& itemMotion = registry.motions.get(entity);
+                    auto& itemMotion = registry.motions.get(entity);
                     float deceleration = 3.f;
                     deceleration = min(deceleration, abs(itemMotion.velocity.x));
 
@@ -1034,7 +1087,7 @@ void WorldSystem::handle_collisions() {
         }
     }
     // Remove all collisions from this simulation Step
-    registry.collisionEvents.clear();
+    registry.contactBuffer.clear();
 
     if (playerHealth.health <= 0.f && !playerComponent.bDead) {
         // DEAD
@@ -1052,11 +1105,12 @@ void WorldSystem::handle_collisions() {
     }
 }
 
-void WorldSystem::CheckCollisionWithBlockable(Entity entity_resolver, Entity entity_other, bool bounce_x, bool is_item) {
-    if (entity_other.GetTag() == TAG_PLAYERBLOCKABLE) {
-        if (registry.colliders.has(entity_resolver) && registry.colliders.has(entity_other)) {
-            CollisionComponent &resolverCollider = registry.colliders.get(entity_resolver);
-            CollisionComponent &otherCollider = registry.colliders.get(entity_other);
+void WorldSystem::CheckCollisionWithBlockable(Entity entity_resolver, const CollisionEvent& colEvent, bool bounce_x, bool is_item) {
+    // Blockables are the solid level tiles, their box comes from the tile grid rather than a collider
+    if (colEvent.isTile && colEvent.other.GetTag() == TAG_PLAYERBLOCKABLE) {
+        if (registry.colliders.has(entity_resolver)) {
+            auto& resolverCollider = registry.colliders.get(entity_resolver);
+            CollisionComponent otherCollider = TileCollider(colEvent);
 
             /** Note(Kevin): This collisionCheckAgain is required because as we resolve collisions
              *  by moving entities around, the initial collection of collision events may become outdated.
@@ -1065,9 +1119,9 @@ void WorldSystem::CheckCollisionWithBlockable(Entity entity_resolver, Entity ent
              *  solutions down the line if needed. */
             CollisionInfo collisionCheckAgain = CheckCollision(resolverCollider, otherCollider);
             if (collisionCheckAgain.collides) {
-                TransformComponent &resolverTransform = registry.transforms.get(entity_resolver);
+                auto& resolverTransform = registry.transforms.get(entity_resolver);
                 if (abs(collisionCheckAgain.collision_overlap.x) < abs(collisionCheckAgain.collision_overlap.y)) {
-                    MotionComponent &resolverMotion = registry.motions.get(entity_resolver);
+                    auto& resolverMotion = registry.motions.get(entity_resolver);
                     resolverTransform.position.x += collisionCheckAgain.collision_overlap.x;
                     resolverCollider.collider_position.x += collisionCheckAgain.collision_overlap.x;
 
@@ -1093,7 +1147,7 @@ void WorldSystem::CheckCollisionWithBlockable(Entity entity_resolver, Entity ent
                     resolverTransform.position.y += collisionCheckAgain.collision_overlap.y;
                     resolverCollider.collider_position.y += collisionCheckAgain.collision_overlap.y;
                     if (collisionCheckAgain.collision_overlap.y > 1) {
-                        MotionComponent& resolverMotion = registry.motions.get(entity_resolver);
+                        auto& resolverMotion = registry.motions.get(entity_resolver);
                         resolverMotion.velocity.y = 0;
                     }
                     
@@ -1114,7 +1168,7 @@ void WorldSystem::UpdateWorldTexts(float dt)
         return;
     }
         
-    TransformComponent& playerTransform = registry.transforms.get(player);
+    auto& playerTransform = registry.transforms.get(player);
     for(int i = 0; i < registry.proximityTexts.size(); ++i)
     {
         ProximityTextComponent& proximText = registry.proximityTexts.components[i];
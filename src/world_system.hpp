@@ -72,8 +72,6 @@ public:
 
     void UpdateMode();
 
-	std::vector<std::vector<int>> levelForAI();
-
 	// Steps the game ahead by deltaTime
 	bool step(float deltaTime);
 
@@ -148,7 +146,7 @@ private:
 
     void SetCurrentMode(GAMEMODE mode);
 
-    void CheckCollisionWithBlockable(Entity entity_resolver, Entity entity_other, bool bounce_x = false, bool is_item = false);
+    void CheckCollisionWithBlockable(Entity entity_resolver, const CollisionEvent& colEvent, bool bounce_x = false, bool is_item = false);
 
     void UpdateWorldTexts(float dt);
 
@@ -165,6 +163,15 @@ private:
 	AISystem* aiSystem;
 	Entity player;
 
+	// Registry snapshot for the 'checkpoint' / 'rewind' console commands
+	RegistrySnapshot checkpoint;
+	GAMELEVELENUM checkpointStage = GAME_NOT_STARTED;
+
+	// How long the last StartNewStage took, for the 'stage_stats' console command
+	float lastTransitionMs = 0.f;
+	float lastTeardownMs = 0.f;
+	size_t lastTeardownEntities = 0;
+
 	// C++ random number generator
 	std::default_random_engine rng;
 	std::uniform_real_distribution<float> uniform_dist; // number between 0..1